@@ -28,13 +28,14 @@ struct PLAYER_NAME : public Player {
   typedef vector<int> VE;
 
   map<int, int> kind; // For cars: 0 -> random, 1 -> Top.
+  VE perm;            // Order of the warriors, reused every round.
 
   void move_warriors() {
     if (round()% 4 != me()) return; // This line makes a lot of sense.
 
     VE W = warriors(me());
     int n = W.size();
-    VE perm = random_permutation(n);
+    random_permutation(perm, n);
     for (int i = 0; i < n; ++i) {
       // id is an own warrior. For some reason (or not) we treat our warriors in random order.
       int id = W[perm[i]];
@@ -67,7 +68,7 @@ struct PLAYER_NAME : public Player {
           else if (unit(id).water > 10) command(id, Left);
           else if (cell(10, 20).owner == 2) command(id, None);
           else if (num_cities(3) == 1) command(id, LB);
-          else cerr << unit(id).pos << endl; // You can print to cerr to debug.
+          else _debug(unit(id).pos); // Shown with --log=debug.
         }
       }
     }
@@ -1,11 +1,8 @@
 #include "Player.hh"
 #include <list>
 
-#ifdef DEBUG
-#define LOG(x) do { cerr << "debug: " << x << endl; } while(0);
-#else
-#define LOG(x)
-#endif
+// Only formatted when running with --log=debug.
+#define LOG(x) _debug(x)
 
 /**
  * Write the name of your player and save this file
@@ -63,6 +60,8 @@ struct PLAYER_NAME : public Player {
     vector<int> enemy_warriors_city;
     vector<int> moved_warriors_city;
 
+    vector<int> perm; // scratch memory for random_permutation
+
     // Helper functions
 
     void bfs(queue<pair<Pos, int> > &q, dmap &m, const bool &cross_city=false);
@@ -118,27 +117,26 @@ struct PLAYER_NAME : public Player {
      * Play method, invoked once per each round.
      */
     virtual void play () {
-        if (round() == 0) init();
+        if (movements.empty()) init(); // if the game did not call it
         LOG("CARS: " << cars(me()).size());
         move_cars();
         move_warriors();
     }
 
-#ifdef DEBUG
     void show_dmap(const dmap &m) {
         for (int i=0; i < rows(); ++i) {
+            ostringstream row;
             for (int j=0; j < cols(); ++j) {
                 const int &v = m[i][j];
-                if (v == INF) cerr << "++";
-                else if (v == -1) cerr << "[]";
-                else if (v%100 < 10) cerr << ' ' << v%100;
-                else cerr << v%100;
-                cerr << ' ';
+                if (v == INF) row << "++";
+                else if (v == -1) row << "[]";
+                else if (v%100 < 10) row << ' ' << v%100;
+                else row << v%100;
+                row << ' ';
             }
-            cerr << endl;
+            LOG(row.str());
         }
     }
-#endif
 
 };
 
@@ -163,20 +161,19 @@ void PLAYER_NAME::init() {
     movements = dmap(rows(), vector<int> (cols(), -1));
     enemy_cars = dmap(rows(), vector<int> (cols(), -1));
     compute_maps();
-#ifdef DEBUG
-    LOG("-- WATER_MAP --")
-        show_dmap(water_map);
-    LOG("-- FUEL_MAP EMPTY --")
-        show_dmap(fuel_map_empty);
-    LOG("-- FUEL_MAP --")
-        show_dmap(fuel_map);
-    LOG("-- NEAREST CITY MAP --")
-        show_dmap(nearest_city);
+    if (not Log::enabled(LogDebug)) return;
+    LOG("-- WATER_MAP --");
+    show_dmap(water_map);
+    LOG("-- FUEL_MAP EMPTY --");
+    show_dmap(fuel_map_empty);
+    LOG("-- FUEL_MAP --");
+    show_dmap(fuel_map);
+    LOG("-- NEAREST CITY MAP --");
+    show_dmap(nearest_city);
     for (int i = 0; i < nb_cities(); ++i) {
         LOG("-- CITY " << i << " --");
         show_dmap(cities_map[i]);
     }
-#endif
 }
 
 void PLAYER_NAME::compute_maps() {
@@ -224,10 +221,11 @@ void PLAYER_NAME::compute_maps() {
 }
 
 void PLAYER_NAME::mark_enemy_cars() {
-    for(const int &player : random_permutation(nb_players()-1)) {
+    random_permutation(perm, nb_players()-1);
+    for(const int &player : perm) {
         if (player == me()) continue;
-        for (const int &car_id : cars(player)) {
-            mark_car_reach(unit(car_id).pos);
+        for (const int &car_id : cars_view(player)) {
+            mark_car_reach(unit_ref(car_id).pos);
         }
     }
 }
@@ -251,7 +249,7 @@ void PLAYER_NAME::mark_car_reach(const Pos &p, const int &depth) {
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
 
             if (ct == Desert) q.emplace(d + nb_players(), p2);
             else if (ct == Road) q.emplace(d + 1, p2);
@@ -273,7 +271,7 @@ void PLAYER_NAME::compute_fuel_map(priority_queue<fq_t, vector<fq_t>, greater<fq
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
             if (ct == Road or ct == Desert)
                 q.emplace(0, p2);
         }
@@ -291,7 +289,7 @@ void PLAYER_NAME::compute_fuel_map(priority_queue<fq_t, vector<fq_t>, greater<fq
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
 
             if (d == -1) q.emplace(0, p2);
             else if (ct == Desert) q.emplace(d + nb_players(), p2);
@@ -313,7 +311,7 @@ void PLAYER_NAME::map_nearest_city(queue<pair<Pos, int> > &q) {
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
             if (ct == Road or ct == Desert) q.emplace(p2, city);
         }
     }
@@ -337,7 +335,7 @@ void PLAYER_NAME::bfs(queue<pair<Pos, int> > &q, dmap &m, const bool &cross_city
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
             if (ct == Road or ct == Desert or (ct == City and cross_city))
                 q.emplace(p2, d+1);
         }
@@ -361,7 +359,7 @@ void PLAYER_NAME::explore_city(const Pos &_p, const int &city, queue<pair<Pos, i
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            if (cell(p2).type == City) {
+            if (cell_ref(p2).type == City) {
                 Q.push(p2);
                 q.emplace(p2, 0);
             }
@@ -373,8 +371,8 @@ void PLAYER_NAME::compute_warriors_city() {
     warriors_player_city = vector<vector<int> > (nb_players(), vector<int>(nb_cities(), 0));
     for (int i = 0; i < nb_cities(); ++i) {
         for (const Pos &p : cities[i]) {
-            if (cell(p).id != -1) {
-                ++warriors_player_city[unit(cell(p).id).player][i];
+            if (cell_ref(p).id != -1) {
+                ++warriors_player_city[unit_ref(cell_ref(p).id).player][i];
             }
         }
     }
@@ -390,7 +388,7 @@ void PLAYER_NAME::compute_warriors_movable() {
 }
 
 void PLAYER_NAME::move_cars() {
-    for (const int &car_id : cars(me()))
+    for (const int &car_id : cars_view(me()))
         if (can_move(car_id))
             move_car(car_id);
 }
@@ -407,10 +405,10 @@ void PLAYER_NAME::move_warriors() {
 
     moved_warriors_city = vector<int> (nb_cities(), 0);
 
-#ifdef DEBUG
-    LOG("-- ENEMY CARS --");
-    show_dmap(enemy_cars);
-#endif
+    if (Log::enabled(LogDebug)) {
+        LOG("-- ENEMY CARS --");
+        show_dmap(enemy_cars);
+    }
 
     for (const int &warrior_id : warriors(me()))
         move_warrior(warrior_id);
@@ -438,7 +436,9 @@ void PLAYER_NAME::move_car(const int &car_id) {
 
         list<Dir> l = get_dir_from_dmap(u, *fm);
         if (l.empty()) {
-            for (const int &i : random_permutation(DirSize-1)) {
+            int order[DirSize-1];
+            random_permutation(order, DirSize-1);
+            for (const int &i : order) {
                 if (!pos_ok(u.pos + Dir(i))) continue;
                 l.push_back(Dir(i));
             }
@@ -453,7 +453,9 @@ void PLAYER_NAME::move_car(const int &car_id) {
     }
 
     list<Dir> l;
-    for (const int &i : random_permutation(DirSize-1)) {
+    int order[DirSize-1];
+    random_permutation(order, DirSize-1);
+    for (const int &i : order) {
         Pos p = u.pos + Dir(i);
 
         if (!pos_ok(p)) continue;
@@ -494,7 +496,7 @@ Dir PLAYER_NAME::get_dir_to_warrior(const list<Dir> &l, const Pos &_p) {
         tuple<int, Dir, Pos> > > q;
 
     for (const Dir &dr : l) {
-        const int d = (cell(_p+dr).type == Road)? 1 : nb_players();
+        const int d = (cell_ref(_p+dr).type == Road)? 1 : nb_players();
         q.emplace(d, dr, _p+dr);
     }
 
@@ -512,9 +514,9 @@ Dir PLAYER_NAME::get_dir_to_warrior(const list<Dir> &l, const Pos &_p) {
         if (visited[p.i][p.j]) continue;
         visited[p.i][p.j] = true;
 
-        const int c_id = cell(p).id;
+        const int c_id = cell_ref(p).id;
         if (c_id != -1) {
-            const Unit u = unit(c_id);
+            const Unit &u = unit_ref(c_id);
             if (u.player != me() and u.type == Warrior) {
                 LOG("FOUND WARRIOR at: (" << u.pos.i << ',' << u.pos.j << ')');
                 LOG("Direction: " << dr);
@@ -526,7 +528,7 @@ Dir PLAYER_NAME::get_dir_to_warrior(const list<Dir> &l, const Pos &_p) {
             const Pos p2 = p + Dir(i);
             if (!pos_ok(p2)) continue;
 
-            const CellType ct = cell(p2).type;
+            const CellType ct = cell_ref(p2).type;
 
             if (ct == Desert) q.emplace(d + nb_players(), dr, p2);
             else if (ct == Road) q.emplace(d + 1, dr, p2);
@@ -555,13 +557,12 @@ void PLAYER_NAME::move_warrior(const int &warrior_id) {
     LOG("  d2Water:" << water_map[u.pos.i][u.pos.j]);
     LOG("  d2Food: " << nearest_city_dmap(u.pos)[u.pos.i][u.pos.j]);
 
-#ifdef DEBUG
-    if (cell(u.pos).type == City and u.food != warriors_health()) {
+    if (Log::enabled(LogDebug)
+        and cell(u.pos).type == City and u.food != warriors_health()) {
         LOG("WARRIOR IN CITY WITH FOOD: " << u.food);
         LOG("city owner: " << cell(u.pos).owner);
         LOG("warrior owner: " << u.player);
     }
-#endif
 
     // If we haven't seen him for 4(nb_players) rounds he has died and respawned
     if (w.last_seen+nb_players() < round()) {
@@ -588,7 +589,9 @@ void PLAYER_NAME::move_warrior(const int &warrior_id) {
 
     list<Dir> l = get_dir_from_dmap(u, *m);
     if (l.empty()) {
-        for (const int &i : random_permutation(DirSize-1)) {
+        int order[DirSize-1];
+        random_permutation(order, DirSize-1);
+        for (const int &i : order) {
             if (!pos_ok(u.pos + Dir(i))) continue;
             l.push_back(Dir(i));
         }
@@ -647,16 +650,17 @@ void PLAYER_NAME::assign_city(Warrior_t &w, const Pos &p) {
         return;
     //if (cell(p).type == City) {
         // If leaving makes us lose city, stay.
-        LOG("ENEMIES IN CITY: " << enemy_warriors_city[city] << endl
-            << "ALLIES:" << warriors_player_city[me()][city] << endl
-            << "moved: " << moved_warriors_city[city] << endl);
+        LOG("ENEMIES IN CITY: " << enemy_warriors_city[city]
+            << " ALLIES:" << warriors_player_city[me()][city]
+            << " moved: " << moved_warriors_city[city]);
         //if (cell(p).owner != me()) return;
         if (warrior_diff_city(city) - moved_warriors_city[city] - 1 < MOVE_OUT_LIMIT) {
             LOG("STAYING NEAREST CITY");
             return;
         }
     //}
-    for (const int &i : random_permutation(nb_cities()-1)) {
+    random_permutation(perm, nb_cities()-1);
+    for (const int &i : perm) {
         if (cities_map[i][p.i][p.j] < warriors_health()-FOOD_MARGIN) {
             w.city = i;
             // try to find unowned cities
@@ -673,7 +677,9 @@ list<Dir> PLAYER_NAME::get_dir_from_dmap(const Unit &u, const dmap &m) {
     const Pos p = u.pos;
     const int d = m[p.i][p.j];
     list<Dir> ls, eq;
-    for (const int &i : random_permutation(DirSize-1)) {
+    int order[DirSize-1];
+    random_permutation(order, DirSize-1);
+    for (const int &i : order) {
         const Pos p2 = p + Dir(i);
         if (!pos_ok(p2)) continue;
 
@@ -689,7 +695,7 @@ list<Dir> PLAYER_NAME::get_dir_from_dmap(const Unit &u, const dmap &m) {
 
 bool PLAYER_NAME::is_unsafe(const Unit &u, const Dir &dr) {
     const Pos p = u.pos + dr;
-    const int u_id = cell(p).id;
+    const int u_id = cell_ref(p).id;
     if (movements[p.i][p.j] == round()) return true;
 
     if (AVOID_ENEMY_CARS) {
@@ -697,22 +703,22 @@ bool PLAYER_NAME::is_unsafe(const Unit &u, const Dir &dr) {
     }
 
     if (u_id != -1) {
-        if (unit(u_id).player == me()) return true;
+        if (unit_ref(u_id).player == me()) return true;
         if (!fight(u.id, u_id)) return true;
     }
     for (int i = 0; i < DirSize-1; ++i) {
         const Pos p2 = p + Dir(i);
         if (!pos_ok(p2)) continue;
 
-        const int u_id2 = cell(p2).id;
+        const int u_id2 = cell_ref(p2).id;
         if (u_id2 == -1) continue;
 
-        if (unit(u_id2).player != me()) {
+        if (unit_ref(u_id2).player != me()) {
             // If moving inside city and menaced by car, we ok
-            if (unit(u_id2).type == Car and cell(p).type == City)
+            if (unit_ref(u_id2).type == Car and cell_ref(p).type == City)
                 continue;
             // cheap fix for Car vs Car bug
-            if (unit(u_id2).type == Car or fight(u_id2, u.id))
+            if (unit_ref(u_id2).type == Car or fight(u_id2, u.id))
                 return true;
         }
     }
@@ -728,8 +734,8 @@ void PLAYER_NAME::remove_unsafe_dirs(const Unit &u, list<Dir> &l) {
 }
 
 bool PLAYER_NAME::fight(const int &attacker_id, const int &victim_id) {
-    const Unit attacker=unit(attacker_id), victim=unit(victim_id);
-    if (cell(victim.pos).type == City and cell(attacker.pos).type == City) return fight_city(attacker, victim);
+    const Unit &attacker=unit_ref(attacker_id), &victim=unit_ref(victim_id);
+    if (cell_ref(victim.pos).type == City and cell_ref(attacker.pos).type == City) return fight_city(attacker, victim);
     return fight_desert(attacker, victim);
 }
 
@@ -2,25 +2,40 @@
 
 
 Action::Action (istream& is) {
-  u_.clear();
-  v_.clear();
+  clear();
 
   // Warning: all read operations must be checked for SecGame.
   int i;
   while (is >> i and i != -1) {
     char d;
     if (is >> d) {
-      u_.insert(i);
       v_.push_back(Movement(i, c2d(d)));
     }
     else {
-      cerr << "warning: only half an operation given for unit " << i << endl;
+      if (Warnings::note(BadInput))
+        _warning("only half an operation given for unit " << i);
       return;
     }
   }
 }
 
 
+void Action::remark () const {
+  Marks& m = marks();
+  m.action = this;
+  if (++m.stamp == 0) {
+    // the stamps went round: old marks could look current
+    fill(m.seen.begin(), m.seen.end(), 0);
+    m.stamp = 1;
+  }
+  for (const Movement& x : v_)
+    if (x.id >= 0 and x.id < MAX_MARKED) {
+      if (x.id >= (int)m.seen.size()) m.seen.resize(x.id + 1, 0);
+      m.seen[x.id] = m.stamp;
+    }
+}
+
+
 void Action::print_actions (const vector<Movement>& actions, ostream& os) {
   for (Movement a : actions) os << a.id << ' ' << d2c(a.dir) << endl;
   os << -1 << endl;
@@ -3,6 +3,7 @@
 
 
 #include "Structs.hh"
+#include "Warning.hh"
 
 
 /**
@@ -29,6 +30,8 @@ class Action {
   friend class Game;
   friend class SecGame;
   friend class Board;
+  friend class Player;
+  friend class Env_batch;
 
   /**
    * Maximum number of movements allowed for a player during one round.
@@ -42,14 +45,75 @@ class Action {
 
   /**
    * Set of units that have already performed a movement.
+   * Only kept for the precompiled players, which still fill it;
+   * repeated units are detected by looking at v_.
    */
   set<int> u_;
 
   /**
    * List of movements to be performed during this round.
+   * Its memory is kept from round to round.
    */
   vector<Movement> v_;
 
+  /**
+   * Marks of the units commanded in the action that the calling thread
+   * filled last, so that repeated units are found without scanning v_.
+   * They live outside the action, whose layout the precompiled players
+   * fix, and are only trusted while that action has had q tries;
+   * otherwise (after clear(), or if another thread commanded it) they
+   * are made again from v_.
+   */
+  struct Marks {
+    const Action* action;
+    int q;
+    unsigned stamp;
+    vector<unsigned> seen;  // Units whose entry is stamp are in v_.
+  };
+
+  /**
+   * Units with higher ids (wrong anyway) are looked for in v_.
+   */
+  static const int MAX_MARKED = 1 << 16;
+
+  static inline Marks& marks () {
+    static thread_local Marks m = { 0, 0, 0, vector<unsigned>() };
+    return m;
+  }
+
+  /**
+   * Makes the marks of the calling thread those of this action.
+   */
+  void remark () const;
+
+  /**
+   * Returns whether unit id is already in the list, and marks it.
+   * Must be called once for each try, after counting it in q_.
+   */
+  inline bool repeated (int id) const {
+    Marks& m = marks();
+    if (_unlikely(m.action != this or m.q != q_ - 1)) remark();
+    m.q = q_;
+    if (_unlikely(id < 0 or id >= MAX_MARKED)) {
+      for (const Movement& x : v_)
+        if (x.id == id) return true;
+      return false;
+    }
+    if (_unlikely(id >= (int)m.seen.size())) m.seen.resize(id + 1, 0);
+    if (m.seen[id] == m.stamp) return true;
+    m.seen[id] = m.stamp;
+    return false;
+  }
+
+  /**
+   * Empties the action, keeping the memory of the list of movements.
+   */
+  inline void clear () {
+    q_ = 0;
+    if (not u_.empty()) u_.clear();
+    v_.clear();
+  }
+
   /**
    * Read/write movements to/from a stream.
    */
@@ -106,13 +170,11 @@ public:
    */
   inline void command (Movement m) {
     _my_assert(++q_ <= MAX_MOVEMENTS, "Too many commands.");
-
-    if (u_.find(m.id) != u_.end()) {
-      cerr << "warning: action already requested for unit " << m.id << endl;
+    if (_unlikely(repeated(m.id))) {
+      if (Warnings::note(RepeatedCommand))
+        _warning("action already requested for unit " << m.id);
       return;
     }
-
-    u_.insert(m.id);
     v_.push_back(m);
   }
 
@@ -122,6 +184,22 @@ public:
   inline void command (int id, Dir dir) {
     command(Movement(id, dir));
   }
+
+  /**
+   * Adds all the given movements to the action list.
+   */
+  inline void command_all (View<Movement> ms) {
+    v_.reserve(v_.size() + ms.size());
+    for (const Movement& m : ms) command(m);
+  }
+
+  /**
+   * Adds a movement in direction dir for all the given units.
+   */
+  inline void command_all (View<int> ids, Dir dir) {
+    v_.reserve(v_.size() + ids.size());
+    for (int id : ids) command(id, dir);
+  }
 };
 
 
@@ -2,10 +2,12 @@
 #include "Action.hh"
 
 
-void Board::capture (int id, int pl, vector<bool>& killed) {
+void Board::capture (int id, int pl, int by, vector<bool>& killed) {
   Unit& u = unit_[id];
   assert(u.player != pl);
 
+  events_.emit(Event(Captured, round(), id, by, pl, u.player, u.pos, u.pos));
+  index_.remove(u.player, u.type, u.pos);
   u.player = pl;
   if (u.type == Warrior) u.food = u.water = warriors_health();
   else {
@@ -25,15 +27,20 @@ void Board::step (int id, Pos p2) {
   c1.id = -1;
   c2.id = id;
   u.pos = p2;
+  index_.remove(u.player, u.type, p1);
+  index_.add(u.player, u.type, p2);
+  events_.emit(Event(Moved, round(), id, -1, u.player, 0, p1, p2));
 }
 
 
-vector<int> Board::two_different (int pl1, int pl2) {
-  vector<int> select;
-  vector<int> perm = random_permutation(nb_players());
-  for (int i = 0; (int)select.size() < 2; ++i) {
+array<int, 2> Board::two_different (int pl1, int pl2) {
+  array<int, 2> select;
+  vector<int>& perm = players_perm_;
+  random_permutation(perm, nb_players());
+  int k = 0;
+  for (int i = 0; k < 2; ++i) {
     int pl = perm[i];
-    if (pl != pl1 and pl != pl2) select.push_back(pl);
+    if (pl != pl1 and pl != pl2) select[k++] = pl;
   }
   return select;
 }
@@ -63,45 +70,47 @@ bool Board::move (int id, Dir dir, vector<bool>& killed) {
   }
 
   Unit& u2 = unit_[id2];
-  vector<int> select = two_different(u.player, u2.player);
+  array<int, 2> select = two_different(u.player, u2.player);
 
   if (u.type == Car) {
     if (u2.type == Car) { // two cars crash (of the same team or not)
-      capture(id2, select[0], killed);
-      capture(id, select[1], killed);
+      capture(id2, select[0], id, killed);
+      capture(id, select[1], id2, killed);
       return true;
     }
 
     if (u2.player == u.player) { // run over own warrior
-      capture(id2, select[0], killed);
+      capture(id2, select[0], id, killed);
       step(id, p2);
       return true;
     }
 
-    capture(id2, u.player, killed); // run over enemy warrior
+    capture(id2, u.player, id, killed); // run over enemy warrior
     step(id, p2);
     return true;
   }
 
   if (u2.type == Car) { // suicidal run over
     if (u2.player == u.player) { // own car
-      capture(id, select[0], killed);
+      capture(id, select[0], id2, killed);
       return true;
     }
 
-    capture(id, u2.player, killed); // enemy car
+    capture(id, u2.player, id2, killed); // enemy car
     return true;
   }
 
   // warrior attacks warrior (of the same team or not)
   if (c1.type == City and c2.type == City) { // thunderdome
     if (random(0, u.water + u2.water - 1) < u.water) {
-      if (u.player == u2.player) capture(id2, select[0], killed);
-      else capture(id2, u.player, killed);
+      events_.emit(Event(Thunderdome, round(), id, id2, u.player, id, p1, p2));
+      if (u.player == u2.player) capture(id2, select[0], id, killed);
+      else capture(id2, u.player, id, killed);
     }
     else {
-      if (u.player == u2.player) capture(id, select[0], killed);
-      else capture(id, u2.player, killed);
+      events_.emit(Event(Thunderdome, round(), id, id2, u.player, id2, p1, p2));
+      if (u.player == u2.player) capture(id, select[0], id2, killed);
+      else capture(id, u2.player, id2, killed);
     }
     return true;
   }
@@ -114,9 +123,10 @@ bool Board::move (int id, Dir dir, vector<bool>& killed) {
   u.food = min(u.food, warriors_health());
   u.water += w/2;
   u.water = min(u.water, warriors_health());
+  events_.emit(Event(Attacked, round(), id, id2, u.player, f + w, p1, p2));
   if (u2.food <= 0 or u2.water <= 0) {
-    if (u2.player == u.player) capture(id2, select[0], killed);
-    else capture(id2, u.player, killed);
+    if (u2.player == u.player) capture(id2, select[0], id, killed);
+    else capture(id2, u.player, id, killed);
   }
   return true;
 }
@@ -146,8 +156,11 @@ void Board::compute_scores () {
       for (int c : counter)
         if (c == mx) ++q;
       if (q == 1) {
+        int old = owner;
         for (int pl = 0; pl < nb_players(); ++pl)
           if (counter[pl] == mx) owner = pl;
+        events_.emit(Event(CityConquered, round(), i, -1, owner, old,
+                           cells_cities_[i][0], cells_cities_[i][0]));
         for (int j = 0; j < (int)cells_cities_[i].size(); ++j) {
           Pos pos = cells_cities_[i][j];
           grid_[pos.i][pos.j].owner = owner;
@@ -161,6 +174,93 @@ void Board::compute_scores () {
 }
 
 
+bool Board::score_bounds (vector<int>& lower, vector<int>& upper) {
+  int np = nb_players();
+  if (city_dist_.empty()) {
+    city_dist_ = vector<vector<int>>(nb_cities());
+    spawn_dist_ = vector<int>(nb_cities(), rows() + cols());
+    for (int c = 0; c < nb_cities(); ++c) {
+      vector<int>& dist = city_dist_[c];
+      dist = vector<int>(rows()*cols(), -1);
+      queue<Pos> Q;
+      for (Pos p : cells_cities_[c]) {
+        dist[p.i*cols() + p.j] = 0;
+        Q.push(p);
+      }
+      while (not Q.empty()) {
+        Pos q = Q.front(); Q.pop();
+        int d = dist[q.i*cols() + q.j];
+        if (grid_[q.i][q.j].type == Desert)
+          spawn_dist_[c] = min(spawn_dist_[c], d);
+        for (int k = 0; k < 8; ++k) {
+          Pos p = q + Dir(k);
+          if (pos_ok(p) and dist[p.i*cols() + p.j] == -1) {
+            dist[p.i*cols() + p.j] = d + 1;
+            Q.push(p);
+          }
+        }
+      }
+    }
+  }
+
+  // number of rounds left in which the warriors of each player move
+  int left = nb_rounds() - round();
+  vector<int> steps(np, 0);
+  for (int pl = 0; pl < np; ++pl) {
+    int first = round() + (pl - round()%np + np)%np;
+    if (first < nb_rounds()) steps[pl] = (nb_rounds() - 1 - first)/np + 1;
+  }
+
+  lower = upper = total_score_;
+  bool exact = true;
+  for (int c = 0; c < nb_cities(); ++c) {
+    Pos p0 = cells_cities_[c][0];
+    int owner = grid_[p0.i][p0.j].owner;
+    const vector<int>& dist = city_dist_[c];
+
+    // captured warriors may respawn on any desert cell
+    bool locked = true;
+    for (int pl = 0; locked and pl < np; ++pl)
+      if (pl != owner and spawn_dist_[c] <= steps[pl]) locked = false;
+    for (int id = 0; locked and id < nb_units(); ++id) {
+      const Unit& u = unit_[id];
+      if (u.type == Warrior and u.player != owner
+          and dist[u.pos.i*cols() + u.pos.j] <= steps[u.player])
+        locked = false;
+    }
+
+    if (locked) {
+      lower[owner] += left;
+      upper[owner] += left;
+    }
+    else {
+      exact = false;
+      for (int pl = 0; pl < np; ++pl) upper[pl] += left;
+    }
+  }
+  return exact;
+}
+
+
+bool Board::result_decided (vector<int>& lower, vector<int>& upper) {
+  if (score_bounds(lower, upper)) return true;
+
+  int best = 0;
+  for (int pl = 1; pl < nb_players(); ++pl)
+    if (lower[pl] > lower[best]) best = pl;
+  for (int pl = 0; pl < nb_players(); ++pl)
+    if (pl != best and upper[pl] >= lower[best]) return false;
+  return true;
+}
+
+
+void Board::decide (const vector<int>& lower, const vector<int>& upper) {
+  total_score_ = lower;
+  if (lower == upper) score_upper_.clear();
+  else score_upper_ = upper;
+}
+
+
 // ***************************************************************************
 
 
@@ -250,21 +350,59 @@ void Board::generate_units () {
 }
 
 
+void Board::use_stream (RngStream s, bool restart) {
+  stream_ = s;
+  if (rng_kind_ != LegacyRng and restart)
+    rng_[s].reseed(Counter_rng::derive(seed_, s, round_));
+}
+
+
+int Board::player_seed (int pl) const {
+  if (rng_kind_ == LegacyRng) return seed_ + pl + 1;
+  return Counter_rng::derive(seed_, PlayerStream, pl) & 0x7fffffff;
+}
+
 // ***************************************************************************
 
 
-Board::Board (istream& is, int seed) {
+Board::Board (istream& is, int seed, RngKind rng)
+  : rng_kind_(rng), seed_(seed) {
   set_random_seed(seed);
+  round_ = 0;
+  use_stream(GeneratorStream, true);
   *static_cast<Settings*>(this) = Settings::read_settings(is);
   names_ = vector<string>(nb_players());
   read_generator_and_grid(is);
+  setup();
+}
+
+
+void Board::restart (int seed) {
+  seed_ = seed;
+  set_random_seed(seed);
   round_ = 0;
-  num_cities_ = vector<int>(nb_players(), 0);
-  total_score_ = vector<int>(nb_players(), 0);
-  cpu_status_ = vector<double>(nb_players(), 0);
-  unit_ = vector<Unit>(nb_players()*(nb_warriors() + nb_cars()));
+  use_stream(GeneratorStream, true);
+  if (generator_ == "FIXED") grid_ = grid0_;
+  else {
+    generator(vector<int>());
+    // the cities have moved
+    city_dist_.clear();
+  }
+  score_upper_.clear();
+  warnings_.clear();
+  setup();
+}
+
+
+void Board::setup () {
+  num_cities_.assign(nb_players(), 0);
+  total_score_.assign(nb_players(), 0);
+  cpu_status_.assign(nb_players(), 0);
+  unit_.assign(nb_players()*(nb_warriors() + nb_cars()), Unit());
   detect_cities();
   generate_units();
+  index_.reset(rows(), cols(), nb_players());
+  for (const Unit& u : unit_) index_.add(u.player, u.type, u.pos);
   update_vectors_by_player();
   compute_scores();
 }
@@ -333,8 +471,11 @@ void Board::print_results () const {
   int max_score = 0;
   vector<int> v;
   for (int pl = 0; pl < nb_players(); ++pl) {
-    cerr << "info: player " << name(pl)
-         << " got score " << total_score(pl) << endl;
+    if (score_upper_.empty())
+      _info("player " << name(pl) << " got score " << total_score(pl));
+    else
+      _info("player " << name(pl) << " got score " << total_score(pl)
+            << " (at most " << score_upper_[pl] << ")");
     if (total_score(pl) > max_score) {
       max_score = total_score(pl);
       v = vector<int>(1, pl);
@@ -342,9 +483,61 @@ void Board::print_results () const {
     else if (total_score(pl) == max_score) v.push_back(pl);
   }
 
-  cerr << "info: player(s)";
-  for (int pl : v) cerr << " " << name(pl);
-  cerr << " got top score" << endl;
+  string top;
+  for (int pl : v) top += " " + name(pl);
+  _info("player(s)" << top << " got top score");
+}
+
+
+void Board::changes_since (long long seq, Changes& ch) {
+  ch.cells_.clear();
+  ch.units_.clear();
+  ch.cities_.clear();
+  ch.all_ = seq < events_.tail() or round() == 0;
+  if (ch.all_) return;
+
+  if ((int)ch.cell_mark_.size() != rows()*cols()) {
+    ch.cell_mark_ = vector<int>(rows()*cols(), 0);
+    ch.unit_mark_ = vector<int>(nb_units(), 0);
+    ch.city_mark_ = vector<int>(nb_cities(), 0);
+  }
+  int stamp = ++ch.stamp_;
+
+  auto add_cell = [&](Pos p) {
+    int& m = ch.cell_mark_[p.i*cols() + p.j];
+    if (m != stamp) {
+      m = stamp;
+      ch.cells_.push_back(p);
+    }
+  };
+
+  for (long long k = seq; k < events_.head(); ++k) {
+    const Event& e = events_.at(k);
+    switch (e.type) {
+      case Moved:
+        add_cell(e.from);
+        add_cell(e.to);
+        break;
+      case Captured:
+        add_cell(e.from);
+        if (ch.unit_mark_[e.id] != stamp) {
+          ch.unit_mark_[e.id] = stamp;
+          ch.units_.push_back(e.id);
+        }
+        break;
+      case Spawned:
+        add_cell(e.to);
+        break;
+      case CityConquered:
+        if (ch.city_mark_[e.id] != stamp) {
+          ch.city_mark_[e.id] = stamp;
+          ch.cities_.push_back(e.id);
+        }
+        for (Pos p : cells_cities_[e.id]) add_cell(p);
+        break;
+      default: ; // do nothing
+    }
+  }
 }
 
 
@@ -354,6 +547,8 @@ void Board::print_results () const {
 void Board::place (int id, Pos p) {
   unit_[id].pos = p;
   grid_[p.i][p.j].id = id;
+  index_.add(unit_[id].player, unit_[id].type, p);
+  events_.emit(Event(Spawned, round(), id, -1, unit_[id].player, 0, p, p));
 }
 
 
@@ -378,41 +573,29 @@ bool Board::pos_safe (Pos p) const {
 
 
 void Board::spawn_cars (const vector<int>& dead_c) {
-  vector<vector<int>> dist(rows(), vector<int>(cols(), -1));
-  queue<Pos> Q;
-  for (int i = 0; i < rows(); ++i)
-    for (int j = 0; j < cols(); ++j) {
-      int id = grid_[i][j].id;
-      if (id != -1) {
-        dist[i][j] = 0;
-        Q.push(Pos(i, j));
-      }
-    }
+  // most rounds nobody dies, and then no random number is drawn either
+  if (dead_c.empty()) return;
 
-  while (not Q.empty()) {
-    Pos q = Q.front(); Q.pop();
-    for (int d = 0; d < 8; ++d) {
-      Pos p = q + Dir(d);
-      if (pos_ok(p) and dist[p.i][p.j] == -1) {
-        dist[p.i][p.j] = dist[q.i][q.j] + 1;
-        Q.push(p);
-      }
-    }
-  }
+  // the cells at distance at least 4 from every unit
+  index_.close_cells(3, close_, close_tmp_);
+  int nw = (cols() + 63)/64;
+  auto far = [&](int i, int j) { return not (close_[i*nw + j/64] >> (j%64) & 1); };
 
   int morts = dead_c.size();
 
-  vector<Pos> pos;
+  vector<Pos>& pos = spawn_pos_;
+  pos.clear();
   for (int i = 1; i < rows(); ++i) {
-    if (grid_[i][0].type == Road and dist[i][0] >= 4) pos.push_back(Pos(i, 0));
-    if (grid_[i][cols()-1].type == Road and dist[i][cols()-1] >= 4) pos.push_back(Pos(i, cols()-1));
+    if (grid_[i][0].type == Road and far(i, 0)) pos.push_back(Pos(i, 0));
+    if (grid_[i][cols()-1].type == Road and far(i, cols()-1)) pos.push_back(Pos(i, cols()-1));
   }
   for (int j = 1; j < cols(); ++j) {
-    if (grid_[0][j].type == Road and dist[0][j] >= 4) pos.push_back(Pos(0, j));
-    if (grid_[rows()-1][j].type == Road and dist[rows()-1][j] >= 4) pos.push_back(Pos(rows()-1, j));
+    if (grid_[0][j].type == Road and far(0, j)) pos.push_back(Pos(0, j));
+    if (grid_[rows()-1][j].type == Road and far(rows()-1, j)) pos.push_back(Pos(rows()-1, j));
   }
 
-  vector<int> perm = random_permutation(morts);
+  vector<int>& perm = spawn_perm_;
+  random_permutation(perm, morts);
   for (int k = 0; k < morts; ++k) {
     Pos p(-1, -1);
     while (p == Pos(-1, -1) and not pos.empty()) {
@@ -469,41 +652,29 @@ void Board::spawn_cars (const vector<int>& dead_c) {
 
 
 void Board::spawn_warriors (const vector<int>& dead_w) {
-  vector<vector<int>> dist(rows(), vector<int>(cols(), -1));
-  queue<Pos> Q;
-  for (int i = 0; i < rows(); ++i)
-    for (int j = 0; j < cols(); ++j) {
-      int id = grid_[i][j].id;
-      if (id != -1) {
-        dist[i][j] = 0;
-        Q.push(Pos(i, j));
-      }
-    }
+  // most rounds nobody dies, and then no random number is drawn either
+  if (dead_w.empty()) return;
 
-  while (not Q.empty()) {
-    Pos q = Q.front(); Q.pop();
-    for (int d = 0; d < 8; ++d) {
-      Pos p = q + Dir(d);
-      if (pos_ok(p) and dist[p.i][p.j] == -1) {
-        dist[p.i][p.j] = dist[q.i][q.j] + 1;
-        Q.push(p);
-      }
-    }
-  }
+  // the cells at distance at least 4 from every unit
+  index_.close_cells(3, close_, close_tmp_);
+  int nw = (cols() + 63)/64;
+  auto far = [&](int i, int j) { return not (close_[i*nw + j/64] >> (j%64) & 1); };
 
   int morts = dead_w.size();
 
-  vector<Pos> pos;
+  vector<Pos>& pos = spawn_pos_;
+  pos.clear();
   for (int i = 1; i < rows() - 1; ++i) {
-    if (grid_[i][0].type == Desert and dist[i][0] >= 4) pos.push_back(Pos(i, 0));
-    if (grid_[i][cols()-1].type == Desert and dist[i][cols()-1] >= 4) pos.push_back(Pos(i, cols()-1));
+    if (grid_[i][0].type == Desert and far(i, 0)) pos.push_back(Pos(i, 0));
+    if (grid_[i][cols()-1].type == Desert and far(i, cols()-1)) pos.push_back(Pos(i, cols()-1));
   }
   for (int j = 1; j < cols() - 1; ++j) {
-    if (grid_[0][j].type == Desert and dist[0][j] >= 4) pos.push_back(Pos(0, j));
-    if (grid_[rows()-1][j].type == Desert and dist[rows()-1][j] >= 4) pos.push_back(Pos(rows()-1, j));
+    if (grid_[0][j].type == Desert and far(0, j)) pos.push_back(Pos(0, j));
+    if (grid_[rows()-1][j].type == Desert and far(rows()-1, j)) pos.push_back(Pos(rows()-1, j));
   }
 
-  vector<int> perm = random_permutation(morts);
+  vector<int>& perm = spawn_perm_;
+  random_permutation(perm, morts);
   for (int k = 0; k < morts; ++k) {
     Pos p(-1, -1);
     while (p == Pos(-1, -1) and not pos.empty()) {
@@ -560,31 +731,48 @@ void Board::spawn_warriors (const vector<int>& dead_w) {
 
 
 void Board::next (const vector<Action>& act, ostream& os) {
+  vector<const Action*> ptr(act.size());
+  for (int pl = 0; pl < (int)act.size(); ++pl) ptr[pl] = &act[pl];
+  next(ptr, os);
+}
+
+
+void Board::next (const vector<const Action*>& act, ostream& os) {
   int np = nb_players();
   int nu = nb_units();
+  use_stream(MovementStream, true);
 
   // chooses (at most) one movement per unit
-  vector<bool> seen(nu, false);
-  vector<Movement> v;
+  vector<bool>& seen = commanded_;
+  vector<Movement>& v = chosen_;
+  seen.assign(nu, false);
+  v.clear();
   for (int pl = 0; pl < np; ++pl)
-    for (const Movement& m : act[pl].v_) {
+    for (const Movement& m : act[pl]->v_) {
       int id = m.id;
       Dir dir = m.dir;
-      if (not unit_ok(id)) cerr << "warning: id out of range :" << id << endl;
+      if (not unit_ok(id)) {
+        if (warnings_.note(IdOutOfRange, pl))
+          _warning("id out of range :" << id);
+      }
       else {
         Unit u = unit(id);
-        if (u.player != pl)
-          cerr << "warning: not own unit: " << id << ' ' << u.player
-               << ' ' << pl << endl;
+        if (u.player != pl) {
+          if (warnings_.note(NotOwnUnit, pl))
+            _warning("not own unit: " << id << ' ' << u.player << ' ' << pl);
+        }
         else {
           _my_assert(not seen[id], "More than one command for the same unit.");
           seen[id] = true;
-          if (not dir_ok(dir))
-            cerr << "warning: direction not valid: " << dir << endl;
+          if (not dir_ok(dir)) {
+            if (warnings_.note(InvalidDir, pl))
+              _warning("direction not valid: " << dir);
+          }
           else if (dir != None) {
-            if (not can_move(id))
-              cerr << "warning: cannot move: " << id << ' ' << pl
-                   << ' ' << round() << endl;
+            if (not can_move(id)) {
+              if (warnings_.note(CannotMove, pl))
+                _warning("cannot move: " << id << ' ' << pl << ' ' << round());
+            }
             else v.push_back(Movement(id, dir));
           }
         }
@@ -593,9 +781,12 @@ void Board::next (const vector<Action>& act, ostream& os) {
   int num = v.size();
 
   // makes all movements using a random order
-  vector<int> perm = random_permutation(num);
-  vector<bool> killed(nu, false);
-  vector<Movement> actions_done;
+  vector<int>& perm = move_perm_;
+  random_permutation(perm, num);
+  vector<bool>& killed = killed_;
+  vector<Movement>& actions_done = done_;
+  killed.assign(nu, false);
+  actions_done.clear();
   for (int i = 0; i < num; ++i) {
     Movement m = v[perm[i]];
     if (not killed[m.id] and move(m.id, m.dir, killed))
@@ -613,15 +804,21 @@ void Board::next (const vector<Action>& act, ostream& os) {
         if (u.type == Warrior) {
           --u.food;
           --u.water;
-          if (u.food == 0 or u.water == 0)
-            capture(id, two_different(u.player, u.player)[0], killed);
+          if (u.food == 0 or u.water == 0) {
+            events_.emit(Event(Starved, round(), id, -1, u.player, 0,
+                               u.pos, u.pos));
+            capture(id, two_different(u.player, u.player)[0], -1, killed);
+          }
         }
         else if (u.food > 0) --u.food;
       }
     }
 
   // spawns units
-  vector<int> dead_w, dead_c;
+  vector<int>& dead_w = dead_w_;
+  vector<int>& dead_c = dead_c_;
+  dead_w.clear();
+  dead_c.clear();
   for (int id = 0; id < nu; ++id)
     if (killed[id]) {
       UnitType t = unit(id).type;
@@ -629,6 +826,7 @@ void Board::next (const vector<Action>& act, ostream& os) {
       (t == Warrior ? dead_w : dead_c).push_back(id);
     }
 
+  use_stream(SpawningStream, true);
   spawn_cars(dead_c);
 
   spawn_warriors(dead_w);
@@ -644,13 +842,16 @@ void Board::next (const vector<Action>& act, ostream& os) {
       assert(ut_ok(u.type));
 #ifdef BOARD_FIX
       if (u.type == Warrior and u.player == round()%4
-          and cell(u.pos).type == City)
-        u.food = warriors_health();
+          and cell(u.pos).type == City) {
 #else
       if (u.type == Warrior and u.player == round()%4
-          and cell(u.pos).owner == u.player)
-        u.food = warriors_health();
+          and cell(u.pos).owner == u.player) {
 #endif
+        if (u.food < warriors_health())
+          events_.emit(Event(FoodRecharged, round(), id, -1, u.player,
+                             warriors_health() - u.food, u.pos, u.pos));
+        u.food = warriors_health();
+      }
     }
 
   // recharges water
@@ -658,8 +859,12 @@ void Board::next (const vector<Action>& act, ostream& os) {
     if (not killed[id]) {
       Unit& u = unit_[id];
       assert(ut_ok(u.type));
-      if (u.type == Warrior and u.player == round()%4 and adjacent(id, Water))
+      if (u.type == Warrior and u.player == round()%4 and adjacent(id, Water)) {
+        if (u.water < warriors_health())
+          events_.emit(Event(WaterRecharged, round(), id, -1, u.player,
+                             warriors_health() - u.water, u.pos, u.pos));
         u.water = warriors_health();
+      }
     }
 
   // recharges fuel
@@ -667,8 +872,12 @@ void Board::next (const vector<Action>& act, ostream& os) {
     if (not killed[id]) {
       Unit& u = unit_[id];
       assert(ut_ok(u.type));
-      if (u.type == Car and can_move(id) and adjacent(id, Station))
+      if (u.type == Car and can_move(id) and adjacent(id, Station)) {
+        if (u.food < cars_fuel())
+          events_.emit(Event(FuelRecharged, round(), id, -1, u.player,
+                             cars_fuel() - u.food, u.pos, u.pos));
         u.food = cars_fuel();
+      }
     }
 
   ++round_;
@@ -680,7 +889,10 @@ void Board::next (const vector<Action>& act, ostream& os) {
 
 void Board::read_generator_and_grid (istream& is) {
   is >> generator_;
-  if (generator_ == "FIXED") read_grid(is);
+  if (generator_ == "FIXED") {
+    read_grid(is);
+    grid0_ = grid_;
+  }
   else {
     vector<int> param;
     int x;
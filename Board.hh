@@ -5,6 +5,9 @@
 #include "Info.hh"
 #include "Action.hh"
 #include "Random.hh"
+#include "Event.hh"
+#include "Index.hh"
+#include <array>
 
 
 /*! \file
@@ -20,11 +23,18 @@ class Board : public Info, public Random_generator {
 
   friend class Game;
   friend class SecGame;
+  friend class Env_batch;
 
   vector<string> names_;
   string generator_;
   vector< vector<Pos> > cells_cities_;
 
+  /**
+   * The grid as read, without units, when the generator is FIXED;
+   * used by restart().
+   */
+  vector< vector<Cell> > grid0_;
+
   /**
    * Used by generate random maps.
    */
@@ -34,11 +44,96 @@ class Board : public Info, public Random_generator {
   vector<vector<Pos>> zone_;
   vector<int> X_, Y_;
 
-  void capture (int id, int pl, vector<bool>& killed);
+  /**
+   * Used by score_bounds: for every city, the Chebyshev distance from
+   * each cell to the city, and the minimum distance from a desert cell.
+   */
+  vector<vector<int>> city_dist_;
+  vector<int> spawn_dist_;
+
+  /**
+   * Upper bounds of the final scores, when the game stopped with the
+   * result decided but the scores not (see decide()); empty otherwise.
+   */
+  vector<int> score_upper_;
+
+  /**
+   * Warnings of this game: those of next(), and those of the threads
+   * that play it (see Warnings::Scope).
+   */
+  Warning_counts warnings_;
+
+  /**
+   * Events produced by next().
+   */
+  Event_stream events_;
+
+  /**
+   * Spatial index of the units on the board, kept up to date
+   * by step(), capture() and place().
+   */
+  Unit_index index_;
+
+  /**
+   * Random generators. With LegacyRng all numbers come from the inherited
+   * Random_generator, in the same order as always. With CounterRng every
+   * stream is independent, and those of next() are restarted every round.
+   */
+  RngKind rng_kind_;
+  int seed_;
+  RngStream stream_;
+  Counter_rng rng_[RngStreamSize];
+
+  /**
+   * Returns a random integer in [l..u] from the current stream.
+   */
+  inline int random (int l, int u) {
+    if (rng_kind_ == LegacyRng) return Random_generator::random(l, u);
+    return rng_[stream_].random(l, u);
+  }
+
+  /**
+   * Returns a random permutation of [0..n-1] from the current stream.
+   */
+  inline vector<int> random_permutation (int n) {
+    if (rng_kind_ == LegacyRng) return Random_generator::random_permutation(n);
+    return rng_[stream_].random_permutation(n);
+  }
+
+  /**
+   * Alias, storing the permutation in v.
+   */
+  inline void random_permutation (vector<int>& v, int n) {
+    if (rng_kind_ == LegacyRng) Random_generator::random_permutation(v, n);
+    else rng_[stream_].random_permutation(v, n);
+  }
+
+  /**
+   * Makes s the current stream. With CounterRng, restarts it
+   * for the current round if restart is true.
+   */
+  void use_stream (RngStream s, bool restart);
+
+  /**
+   * Scratch memory of next(), kept between rounds to avoid allocations.
+   */
+  vector<Movement> chosen_, done_;
+  vector<bool> commanded_, killed_;
+  vector<int> move_perm_, spawn_perm_, players_perm_, dead_w_, dead_c_;
+  vector<uint64_t> close_, close_tmp_;
+  vector<Pos> spawn_pos_;
+
+  /**
+   * Gives unit id to player pl. by is the unit that caused it, or -1.
+   */
+  void capture (int id, int pl, int by, vector<bool>& killed);
 
   void step (int id, Pos p2);
 
-  vector<int> two_different (int pl1, int pl2);
+  /**
+   * Returns two random players different from pl1 and pl2.
+   */
+  array<int, 2> two_different (int pl1, int pl2);
 
   /**
    * Tries to apply a move. Returns true if it could. Marks killed units.
@@ -72,6 +167,12 @@ class Board : public Info, public Random_generator {
    */
   void generate_units ();
 
+  /**
+   * Starts a game on the grid just made: places the units and computes
+   * the scores of round 0.
+   */
+  void setup ();
+
   /**
    * Reads the generator method, and generates or reads the grid.
    */
@@ -137,10 +238,43 @@ public:
     return names_[player];
   }
 
+  /**
+   * Returns the events produced by the last calls to next().
+   */
+  inline const Event_stream& events () const {
+    return events_;
+  }
+
+  /**
+   * Returns the spatial index of the units on the board.
+   */
+  inline const Unit_index& unit_index () const {
+    return index_;
+  }
+
+  /**
+   * Fills ch with what changed from the event with sequence number seq
+   * up to the last event. The cells of a conquered city are included.
+   */
+  void changes_since (long long seq, Changes& ch);
+
   /**
    * Construct a board by reading information from a stream.
    */
-  Board (istream& is, int seed);
+  Board (istream& is, int seed, RngKind rng = LegacyRng);
+
+  /**
+   * Starts the game again with another seed, without reading the
+   * settings again: the board is the same as one constructed from the
+   * same stream with that seed, except that the names are kept and the
+   * events go on from the last one.
+   */
+  void restart (int seed);
+
+  /**
+   * Returns the random seed for player pl.
+   */
+  int player_seed (int pl) const;
 
   /**
    * Prints the board preamble to a stream.
@@ -159,9 +293,40 @@ public:
 
   /**
    * Prints the results and the names of the winning players.
+   * Scores that are only bounds are printed as such.
    */
   void print_results () const;
 
+  /**
+   * Computes lower and upper bounds of the total score that every player
+   * will have after the last round. A city is locked when no warrior
+   * can still reach it in time to contest it. Returns whether the bounds
+   * are exact, that is, whether all the cities are locked.
+   */
+  bool score_bounds (vector<int>& lower, vector<int>& upper);
+
+  /**
+   * Returns whether no player can change the top ranking anymore,
+   * and stores the bounds of the final scores in lower and upper.
+   */
+  bool result_decided (vector<int>& lower, vector<int>& upper);
+
+  /**
+   * Ends the game with the bounds given by result_decided(). The total
+   * scores become the lower bounds, so that the decided leader is the
+   * only one with the top score, and the upper bounds are kept, unless
+   * they are the same.
+   */
+  void decide (const vector<int>& lower, const vector<int>& upper);
+
+  /**
+   * Returns the upper bounds kept by decide(), or an empty vector if
+   * the total scores are exact.
+   */
+  inline const vector<int>& score_upper () const {
+    return score_upper_;
+  }
+
   /**
    * Used by next() to spawn dead cars.
    */
@@ -176,6 +341,11 @@ public:
    * Computes the next board aplying the given actions to the current board.
    * It also prints to os the actual actions performed.
    */
+  void next (const vector<const Action*>& act, ostream& os);
+
+  /**
+   * Alias, for actions owned by the caller.
+   */
   void next (const vector<Action>& act, ostream& os);
 
 };
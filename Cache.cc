@@ -0,0 +1,178 @@
+#include "Cache.hh"
+
+
+Query_cache::Query_cache (const Info& info)
+  : info_(&info), nb_segments_(0), grid_(false) {
+  for (int g = 0; g < GroupSize; ++g) computed_[g] = -1;
+}
+
+
+void Query_cache::compute (int g) const {
+  if (g == GroupSize) {
+    lock_guard<mutex> l(mutex_[g]);
+    if (grid_.load(memory_order_relaxed)) return;
+    compute_grid();
+    grid_.store(true, memory_order_release);
+    return;
+  }
+
+  need_grid();
+  lock_guard<mutex> l(mutex_[g]);
+  int r = info_->round();
+  if (computed_[g].load(memory_order_relaxed) == r) return;
+  switch (g) {
+    case WarriorsCity: compute_warriors_city(); break;
+    case Adjacent:     compute_adjacent();      break;
+    case CarsSegment:  compute_cars_segment();  break;
+    case Positions:    compute_positions();     break;
+    case Fields:       compute_fields();        break;
+    case Moves:        compute_moves();         break;
+  }
+  computed_[g].store(r, memory_order_release);
+}
+
+
+void Query_cache::compute_grid () const {
+  const Info& in = *info_;
+  int n = in.rows()*in.cols();
+  city_of_ = vector<int>(n, -1);
+  segment_of_ = vector<int>(n, -1);
+  cities_.clear();
+  nb_segments_ = 0;
+
+  auto type = [&](int i, int j) {
+    return in.pos_ok(i, j) ? in.grid_[i][j].type : Wall;
+  };
+  auto junction = [&](int i, int j) {
+    auto rs = [&](int x, int y) {
+      return type(x, y) == Road or type(x, y) == Station;
+    };
+    return (rs(i - 1, j) or rs(i + 1, j)) and (rs(i, j - 1) or rs(i, j + 1));
+  };
+
+  for (int i = 0; i < in.rows(); ++i)
+    for (int j = 0; j < in.cols(); ++j) {
+      CellType t = in.grid_[i][j].type;
+      bool new_city = t == City and city_of_[index(Pos(i, j))] == -1;
+      bool new_segment = t == Road and segment_of_[index(Pos(i, j))] == -1
+                         and not junction(i, j);
+      if (not new_city and not new_segment) continue;
+
+      vector<int>& mark = new_city ? city_of_ : segment_of_;
+      int label = new_city ? (int)cities_.size() : nb_segments_++;
+      if (new_city) cities_.push_back(vector<Pos>());
+      stack<Pos> S;
+      mark[index(Pos(i, j))] = label;
+      S.push(Pos(i, j));
+      while (not S.empty()) {
+        Pos q = S.top(); S.pop();
+        if (new_city) cities_.back().push_back(q);
+        for (int d = 0; d < 8; d += 2) {
+          Pos p = q + Dir(d);
+          if (type(p.i, p.j) != t or mark[index(p)] != -1) continue;
+          if (new_segment and junction(p.i, p.j)) continue;
+          mark[index(p)] = label;
+          S.push(p);
+        }
+      }
+    }
+
+  // for every cell, the directions to cells each type of unit can enter,
+  // one direction at a time over a grid padded with a border of walls
+  int w = in.cols() + 2;
+  vector<uint8_t> enter[UnitTypeSize];
+  for (int t = 0; t < UnitTypeSize; ++t) {
+    enter[t].assign((in.rows() + 2)*w, 0);
+    terrain_[t].assign(n, 0);
+  }
+  for (int i = 0; i < in.rows(); ++i)
+    for (int j = 0; j < in.cols(); ++j) {
+      CellType ct = in.grid_[i][j].type;
+      enter[Warrior][(i + 1)*w + j + 1] = (ct == Desert or ct == Road or ct == City);
+      enter[Car][(i + 1)*w + j + 1] = (ct == Desert or ct == Road);
+    }
+  for (int t = 0; t < UnitTypeSize; ++t)
+    for (int d = 0; d < 8; ++d) {
+      Pos off = Pos(0, 0) + Dir(d);
+      for (int i = 0; i < in.rows(); ++i) {
+        const uint8_t* src = &enter[t][(i + 1 + off.i)*w + 1 + off.j];
+        uint8_t* dst = &terrain_[t][i*in.cols()];
+        for (int j = 0; j < in.cols(); ++j) dst[j] |= src[j] << d;
+      }
+    }
+}
+
+
+void Query_cache::compute_warriors_city () const {
+  const Info& in = *info_;
+  warriors_city_ = vector<int>(cities_.size()*in.nb_players(), 0);
+  for (const Unit& u : in.unit_) {
+    int c = city_of_[index(u.pos)];
+    if (c != -1 and u.type == Warrior)
+      ++warriors_city_[c*in.nb_players() + u.player];
+  }
+}
+
+
+void Query_cache::compute_adjacent () const {
+  const Info& in = *info_;
+  int np = in.nb_players();
+  adjacent_.assign(in.rows()*in.cols()*np, 0);
+  for (const Unit& u : in.unit_)
+    for (int d = 0; d < 8; ++d) {
+      Pos p = u.pos + Dir(d);
+      if (in.pos_ok(p)) ++adjacent_[index(p)*np + u.player];
+    }
+}
+
+
+void Query_cache::compute_cars_segment () const {
+  const Info& in = *info_;
+  cars_segment_.assign(nb_segments_*in.nb_players(), 0);
+  for (const Unit& u : in.unit_) {
+    int s = segment_of_[index(u.pos)];
+    if (s != -1 and u.type == Car)
+      ++cars_segment_[s*in.nb_players() + u.player];
+  }
+}
+
+
+void Query_cache::compute_positions () const {
+  const Info& in = *info_;
+  positions_.resize(in.nb_players()*UnitTypeSize);
+  for (vector<Pos>& v : positions_) v.clear();
+  for (const Unit& u : in.unit_)
+    positions_[u.player*UnitTypeSize + u.type].push_back(u.pos);
+}
+
+
+void Query_cache::compute_fields () const {
+  influence_[Warrior].compute(*info_, Warrior);
+  influence_[Car].compute(*info_, Car);
+}
+
+
+void Query_cache::compute_moves () const {
+  const Info& in = *info_;
+  int nu = in.nb_units();
+  legal_.assign(nu, 0);
+  own_.assign(nu, 0);
+  enemy_.assign(nu, 0);
+  target_.assign(8*nu, -1);
+  for (int id = 0; id < nu; ++id) {
+    const Unit& u = in.unit_[id];
+    for (int d = 0; d < 8; ++d) {
+      Pos p = u.pos + Dir(d);
+      if (in.pos_ok(p)) target_[8*id + d] = in.grid_[p.i][p.j].id;
+    }
+    if (not in.can_move(id)) continue;
+    uint8_t m = terrain_[u.type][index(u.pos)];
+    legal_[id] = m;
+    for (int d = 0; d < 8; ++d) {
+      int id2 = target_[8*id + d];
+      if (not (m >> d & 1) or id2 == -1) continue;
+      if (in.unit_[id2].player == u.player) own_[id] |= 1 << d;
+      else enemy_[id] |= 1 << d;
+    }
+  }
+}
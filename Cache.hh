@@ -0,0 +1,234 @@
+#ifndef Cache_hh
+#define Cache_hh
+
+
+#include "Influence.hh"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+
+/** \file
+ * Contains a class that memoizes queries derived from the state of a round.
+ */
+
+
+/**
+ * Answers queries that most players derive from the state every round.
+ *
+ * Every group of queries is computed on first use and kept until the
+ * round of the underlying Info changes, so that nobody pays for the
+ * queries that nobody makes. The game shares one cache with every
+ * player, whose workers may query it at the same time: the first one
+ * computes the group while the others wait. A player can also build
+ * its own cache on top of itself, with Query_cache(*this).
+ *
+ * Move masks have bit d set for direction Dir(d), d in [0, 8).
+ *
+ * Cities are numbered in row-major order of their first cell,
+ * and road segments are the 4-connected groups of road cells
+ * that are not junctions (a junction has roads or stations both
+ * vertically and horizontally next to it).
+ */
+class Query_cache {
+
+  const Info* info_;
+
+  /**
+   * Depend only on the grid, computed once.
+   */
+  mutable vector<vector<Pos>> cities_;
+  mutable vector<int> city_of_;
+  mutable vector<int> segment_of_;
+  mutable int nb_segments_;
+  mutable vector<uint8_t> terrain_[UnitTypeSize];
+
+  /**
+   * Depend on the round. Indexed by [what*nb_players() + player].
+   */
+  mutable vector<int> warriors_city_;
+  mutable vector<int> adjacent_;
+  mutable vector<int> cars_segment_;
+  mutable vector<vector<Pos>> positions_;
+  mutable Influence influence_[UnitTypeSize];
+  mutable vector<uint8_t> legal_, own_, enemy_;
+  mutable vector<int> target_;
+
+  /**
+   * Round in which each group was computed, or -1, and whether the
+   * grid was. Each is written, after its group, holding its mutex.
+   */
+  enum { WarriorsCity, Adjacent, CarsSegment, Positions, Fields,
+         Moves, GroupSize };
+  mutable atomic<int> computed_[GroupSize];
+  mutable atomic<bool> grid_;
+  mutable mutex mutex_[GroupSize + 1];
+
+  /**
+   * Computes group g (or the grid, if GroupSize) unless another
+   * thread did it meanwhile.
+   */
+  void compute (int g) const;
+
+  void compute_grid () const;
+  void compute_warriors_city () const;
+  void compute_adjacent () const;
+  void compute_cars_segment () const;
+  void compute_positions () const;
+  void compute_fields () const;
+  void compute_moves () const;
+
+  /**
+   * Makes sure that the grid has been computed.
+   */
+  inline void need_grid () const {
+    if (_unlikely(not grid_.load(memory_order_acquire))) compute(GroupSize);
+  }
+
+  /**
+   * Makes sure that group g has been computed for the current round.
+   */
+  inline void need (int g) const {
+    if (_unlikely(computed_[g].load(memory_order_acquire) != info_->round()))
+      compute(g);
+  }
+
+  /**
+   * Returns the index of the cell at p in the flat arrays.
+   */
+  inline int index (Pos p) const {
+    return p.i*info_->cols() + p.j;
+  }
+
+public:
+
+  /**
+   * Constructor, given the information the queries are about.
+   */
+  explicit Query_cache (const Info& info);
+
+  /**
+   * Returns the cells of every city.
+   */
+  inline const vector<vector<Pos>>& cities () const {
+    need_grid();
+    return cities_;
+  }
+
+  /**
+   * Returns the city of the cell at p, or -1.
+   */
+  inline int city (Pos p) const {
+    need_grid();
+    return city_of_[index(p)];
+  }
+
+  /**
+   * Returns the number of road segments.
+   */
+  inline int nb_segments () const {
+    need_grid();
+    return nb_segments_;
+  }
+
+  /**
+   * Returns the road segment of the cell at p, or -1.
+   */
+  inline int segment (Pos p) const {
+    need_grid();
+    return segment_of_[index(p)];
+  }
+
+  /**
+   * Returns the number of warriors of player pl inside city c.
+   */
+  inline int warriors_in_city (int c, int pl) const {
+    need(WarriorsCity);
+    return warriors_city_[c*info_->nb_players() + pl];
+  }
+
+  /**
+   * Returns the number of units of player pl in the 8 cells around p.
+   */
+  inline int adjacent_units (Pos p, int pl) const {
+    need(Adjacent);
+    return adjacent_[index(p)*info_->nb_players() + pl];
+  }
+
+  /**
+   * Returns the number of units not of player pl in the 8 cells around p.
+   */
+  inline int adjacent_enemies (Pos p, int pl) const {
+    need(Adjacent);
+    int np = info_->nb_players();
+    int n = 0;
+    for (int k = 0; k < np; ++k)
+      if (k != pl) n += adjacent_[index(p)*np + k];
+    return n;
+  }
+
+  /**
+   * Returns the number of cars of player pl on road segment s.
+   */
+  inline int cars_in_segment (int s, int pl) const {
+    need(CarsSegment);
+    return cars_segment_[s*info_->nb_players() + pl];
+  }
+
+  /**
+   * Returns the positions of the units of player pl of type t.
+   */
+  inline const vector<Pos>& positions (int pl, UnitType t) const {
+    need(Positions);
+    return positions_[pl*UnitTypeSize + t];
+  }
+
+  /**
+   * Returns the directions in which unit id can move this round,
+   * following the rules of Board::move (whatever is on the target cell).
+   * It is 0 if the unit cannot move this round.
+   */
+  inline uint8_t legal_moves (int id) const {
+    need(Moves);
+    return legal_[id];
+  }
+
+  /**
+   * Returns the legal directions of unit id whose target cell
+   * has a unit of the same player.
+   */
+  inline uint8_t own_targets (int id) const {
+    need(Moves);
+    return own_[id];
+  }
+
+  /**
+   * Returns the legal directions of unit id whose target cell
+   * has a unit of another player.
+   */
+  inline uint8_t enemy_targets (int id) const {
+    need(Moves);
+    return enemy_[id];
+  }
+
+  /**
+   * Returns the id of the unit in the cell that unit id would reach by
+   * moving in direction d (not None), or -1 if empty or outside the board.
+   */
+  inline int target (int id, Dir d) const {
+    need(Moves);
+    return target_[8*id + d];
+  }
+
+  /**
+   * Returns the influence fields of the units of type t.
+   */
+  inline const Influence& influence (UnitType t) const {
+    need(Fields);
+    return influence_[t];
+  }
+
+};
+
+
+#endif
@@ -0,0 +1,58 @@
+#include "Combat.hh"
+
+
+Combat::Combat (const Settings& s)
+  : health_(s.warriors_health()), damage_(s.damage()),
+    n_(s.warriors_health() + 1), built_(false) {
+}
+
+
+void Combat::build () const {
+  lock_guard<mutex> l(mutex_);
+  if (built_.load(memory_order_relaxed)) return;
+  int h = health_;
+  int n = n_;
+
+  thunder_ = vector<float>(n*n, 0);
+  for (int a = 0; a < n; ++a)
+    for (int b = 0; b < n; ++b)
+      if (a + b > 0) thunder_[a*n + b] = double(a)/(a + b);
+
+  // Every attack (plus the upkeep of the attacker) strictly decreases
+  // the sum of the four values, so states are solved by increasing sum.
+  duel_ = vector<uint16_t>(n*n*n*n, 0);
+  for (int sum = 0; sum <= 4*h; ++sum)
+    for (int af = max(0, sum - 3*h); af <= min(h, sum); ++af)
+      for (int aw = max(0, sum - af - 2*h); aw <= min(h, sum - af); ++aw)
+        for (int bf = max(0, sum - af - aw - h); bf <= min(h, sum - af - aw); ++bf) {
+          int bw = sum - af - aw - bf;
+          uint16_t& r = duel_[index(af, aw, bf, bw)];
+          if (bf == 0 or bw == 0) r = 1 << 15;  // the victim is already dead
+          else if (af == 0 or aw == 0) r = 0;  // the attacker is already dead
+          else {
+            int f = min(bf, damage_);
+            int w = min(bw, damage_);
+            int bf2 = bf - f;
+            int bw2 = bw - w;
+            int af2 = min(af + f/2, h) - 1;
+            int aw2 = min(aw + w/2, h) - 1;
+            if (bf2 == 0 or bw2 == 0) r = (1 << 15) | 1;
+            else if (af2 == 0 or aw2 == 0) r = 1;
+            else {
+              uint16_t next = duel_[index(bf2, bw2, af2, aw2)];
+              r = ((~next) & (1 << 15)) | ((next & 0x7fff) + 1);
+            }
+          }
+        }
+  built_.store(true, memory_order_release);
+}
+
+
+double Combat::wins (const Unit& a, CellType ca, const Unit& b, CellType cb) const {
+  if (cb != Desert and cb != Road and (cb != City or a.type != Warrior))
+    return -1;
+  if (a.type == Car) return 1;     // crashes capture b (and a, if a car)
+  if (b.type == Car) return 0;     // suicidal run over
+  if (ca == City and cb == City) return thunderdome(a.water, b.water);
+  return duel_wins(a.food, a.water, b.food, b.water);
+}
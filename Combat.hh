@@ -0,0 +1,129 @@
+#ifndef Combat_hh
+#define Combat_hh
+
+
+#include "Settings.hh"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+
+/** \file
+ * Contains a class to predict the result of fights between units.
+ */
+
+
+/**
+ * Combat oracle, following the rules of Board::move.
+ *
+ * For warriors fighting outside a thunderdome it has a table with the
+ * result of a duel for all the values of food and water in
+ * [0, warriors_health()]. In a duel both warriors attack each other in
+ * turns, starting with the attacker. Every attack takes min(damage(), x)
+ * food and water from the victim and gives half of each to the attacker,
+ * and then the attacker spends one unit of food and water, as every
+ * warrior does in the rounds it can move. Recharges are not considered.
+ *
+ * Thunderdome probabilities are exact: the attacker wins with
+ * probability water/(water + water of the defender).
+ *
+ * The tables are computed once, by the first query that needs them
+ * (several threads may make it at the same time), so that games where
+ * nobody asks do not pay for them.
+ */
+class Combat {
+
+  int health_;
+  int damage_;
+  int n_;
+
+  /**
+   * Result of a duel indexed by the food and water of the attacker
+   * and of the victim: bit 15 tells if the attacker wins,
+   * and the other bits the number of attacks until the duel ends.
+   */
+  mutable vector<uint16_t> duel_;
+
+  /**
+   * Thunderdome probabilities, indexed by the water of both warriors.
+   */
+  mutable vector<float> thunder_;
+
+  /**
+   * Whether the tables are computed, and the mutex of whoever does it.
+   */
+  mutable atomic<bool> built_;
+  mutable mutex mutex_;
+
+  /**
+   * Computes the tables, unless another thread did it meanwhile.
+   */
+  void build () const;
+
+  inline void need () const {
+    if (_unlikely(not built_.load(memory_order_acquire))) build();
+  }
+
+  inline int index (int af, int aw, int bf, int bw) const {
+    return ((af*n_ + aw)*n_ + bf)*n_ + bw;
+  }
+
+  inline static int clamp (int x, int h) {
+    return x < 0 ? 0 : (x > h ? h : x);
+  }
+
+public:
+
+  /**
+   * Constructor, for the given settings. The tables are built later.
+   */
+  explicit Combat (const Settings& s);
+
+  /**
+   * Returns whether a warrior with food af and water aw wins a duel
+   * against a warrior with food bf and water bw, attacking first.
+   */
+  inline bool duel_wins (int af, int aw, int bf, int bw) const {
+    need();
+    int h = health_;
+    return duel_[index(clamp(af, h), clamp(aw, h), clamp(bf, h), clamp(bw, h))] >> 15;
+  }
+
+  /**
+   * Returns the number of attacks (of both warriors) that the duel lasts.
+   */
+  inline int duel_length (int af, int aw, int bf, int bw) const {
+    need();
+    int h = health_;
+    return duel_[index(clamp(af, h), clamp(aw, h), clamp(bf, h), clamp(bw, h))] & 0x7fff;
+  }
+
+  /**
+   * Returns whether a single attack outside a thunderdome
+   * captures a warrior with food bf and water bw.
+   */
+  inline bool kills (int bf, int bw) const {
+    return bf <= damage_ or bw <= damage_;
+  }
+
+  /**
+   * Returns the probability that a warrior with water aw
+   * wins a thunderdome against a warrior with water bw.
+   */
+  inline double thunderdome (int aw, int bw) const {
+    need();
+    return thunder_[clamp(aw, health_)*n_ + clamp(bw, health_)];
+  }
+
+  /**
+   * Returns the probability that unit a, moving from a cell of type ca,
+   * captures unit b in a cell of type cb. Returns -1 if a cannot move
+   * there, and 0 if a would be captured (or nothing would be decided)
+   * instead. Warriors fighting outside a thunderdome use the duel table.
+   */
+  double wins (const Unit& a, CellType ca, const Unit& b, CellType cb) const;
+
+};
+
+
+#endif
@@ -0,0 +1,33 @@
+#include "Deadline.hh"
+#include "Pool.hh"
+#include <pthread.h>
+
+
+Deadline::Deadline ()
+  : start_(0), round_(0), total_(0), limit_(0),
+    clock_(CLOCK_THREAD_CPUTIME_ID), pool_(0), now_(0), calls_(0) { }
+
+
+void Deadline::start (double round_budget, double total_left,
+                      const Worker_pool* pool) {
+  round_ = round_budget;
+  total_ = total_left;
+  limit_ = round_;
+  if (total_ > 0 and (limit_ == 0 or total_ < limit_)) limit_ = total_;
+  pool_ = pool;
+  if (pthread_getcpuclockid(pthread_self(), &clock_) != 0)
+    clock_ = CLOCK_THREAD_CPUTIME_ID;
+  calls_ = 0;
+  start_ = 0;
+  start_ = refresh();
+}
+
+
+double Deadline::refresh () const {
+  timespec t;
+  clock_gettime(clock_, &t);
+  double now = t.tv_sec + 1e-9*t.tv_nsec;
+  if (pool_) now += pool_->cpu_so_far();
+  now_.store(now, memory_order_relaxed);
+  return now - start_;
+}
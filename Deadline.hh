@@ -0,0 +1,131 @@
+#ifndef Deadline_hh
+#define Deadline_hh
+
+
+#include "Utils.hh"
+#include <atomic>
+#include <time.h>
+
+
+class Worker_pool;
+
+
+/** \file
+ * Contains the Deadline class, which tells a player how much cpu time
+ * it has left.
+ */
+
+
+/**
+ * Cpu time budget of a player for the current call to play().
+ *
+ * The limit is the smallest of the budget for the round and what is
+ * left of the budget for the game; if neither is set there is no limit.
+ * Times are what the game charges: the cpu time of the thread where the
+ * deadline was started (the one that runs play()), plus that of the
+ * tasks of the worker pool of the player that have finished since.
+ * Any thread may ask, workers included.
+ *
+ * should_stop() is meant to be called often, from the inner loops of a
+ * search: it only reads the clocks once every few calls.
+ */
+class Deadline {
+
+  double start_;   // Cpu time when play() was called, of its thread and pool.
+  double round_;   // Budget for this round, or 0.
+  double total_;   // Budget left for the game when play() was called, or 0.
+  double limit_;   // Smallest of both, or 0.
+
+  clockid_t clock_;           // Cpu clock of the thread of play().
+  const Worker_pool* pool_;   // Workers of the player, or null.
+
+  // last reading, shared by all the threads that ask
+  mutable atomic<double> now_;
+  mutable atomic<int> calls_;
+
+  /**
+   * Reads the clocks.
+   */
+  double refresh () const;
+
+public:
+
+  /**
+   * Number of calls to should_stop() between two readings of the clock.
+   */
+  static const int CHECK_EVERY = 64;
+
+  /**
+   * Creates a deadline without limit.
+   */
+  Deadline ();
+
+  /**
+   * Starts the deadline of a round, with the given budgets in seconds
+   * (0 if not set), in the thread that is going to use them. The cpu
+   * time of the tasks of pool counts too.
+   */
+  void start (double round_budget, double total_left,
+              const Worker_pool* pool = 0);
+
+  /**
+   * Returns whether there is any limit.
+   */
+  inline bool limited () const {
+    return limit_ > 0;
+  }
+
+  /**
+   * Returns the cpu seconds used since play() was called.
+   */
+  inline double elapsed () const {
+    return refresh();
+  }
+
+  /**
+   * Returns the cpu seconds left until the limit, or a huge
+   * value if there is no limit.
+   */
+  inline double remaining () const {
+    return limited() ? limit_ - refresh() : 1e18;
+  }
+
+  /**
+   * Returns the budget for this round, or 0 if not set.
+   */
+  inline double round_budget () const {
+    return round_;
+  }
+
+  /**
+   * Returns the budget left for the game when play() was called,
+   * or 0 if not set.
+   */
+  inline double total_left () const {
+    return total_;
+  }
+
+  /**
+   * Returns whether the limit has been reached, reading the clock.
+   */
+  inline bool expired () const {
+    return limited() and refresh() >= limit_;
+  }
+
+  /**
+   * Returns whether less than margin seconds are left. The clock is only
+   * read once every CHECK_EVERY calls; otherwise the last reading is used.
+   */
+  inline bool should_stop (double margin = 0) const {
+    if (not limited()) return false;
+    if (calls_.fetch_add(1, memory_order_relaxed) + 1 >= CHECK_EVERY) {
+      calls_.store(0, memory_order_relaxed);
+      refresh();
+    }
+    return now_.load(memory_order_relaxed) - start_ + margin >= limit_;
+  }
+
+};
+
+
+#endif
@@ -0,0 +1,295 @@
+#include "Env.hh"
+
+
+// the C interface hands out these structs as arrays of ints
+static_assert(sizeof(Cell) == 3*sizeof(int), "Cell is not three ints.");
+static_assert(sizeof(Unit) == 7*sizeof(int), "Unit is not seven ints.");
+static_assert(sizeof(Movement) == 2*sizeof(int), "Movement is not two ints.");
+
+
+Env_batch::Env_batch (int n, const string& config, int seed, RngKind rng,
+                      int threads)
+  : n_(n), pool_(threads) {
+  _my_assert(n > 0, "Wrong number of games.");
+  boards_.resize(n);
+  seq_.resize(n);
+  changes_.resize(n);
+  act_.resize(n);
+  offset_.resize(n);
+  for (int g = 0; g < n; ++g) null_.emplace_back(new ostream(0));
+
+  // the first board gives the sizes of everything else
+  istringstream iss(config);
+  boards_[0].reset(new Board(iss, seed, rng));
+  const Board& b = *boards_[0];
+  np_ = b.nb_players();
+  nu_ = b.nb_units();
+  rows_ = b.rows();
+  cols_ = b.cols();
+  nr_ = b.nb_rounds();
+
+  actions_.resize(n*np_);
+  cells_.resize(size_t(n)*rows_*cols_);
+  units_.resize(size_t(n)*nu_);
+  num_cities_.resize(n*np_);
+  total_score_.resize(n*np_);
+  round_.resize(n);
+  done_.resize(n);
+
+  for (int g = 0; g < n; ++g) {
+    act_[g].resize(np_);
+    for (int pl = 0; pl < np_; ++pl) act_[g][pl] = &actions_[g*np_ + pl];
+  }
+  encoders_.assign(n, Plane_encoder(b));
+  sync(0, true);
+
+  // the others are copies, started with their own seeds
+  pool_.parallel_for(n - 1, [&](int k) {
+    boards_[k + 1].reset(new Board(*boards_[0]));
+    reset(k + 1, seed + k + 1);
+  });
+}
+
+
+void Env_batch::sync (int g, bool all) {
+  const Board& b = *boards_[g];
+  Cell* c = cells_.data() + size_t(g)*rows_*cols_;
+  if (not all) {
+    boards_[g]->changes_since(seq_[g], changes_[g]);
+    all = changes_[g].all();
+  }
+  if (all) {
+    for (int i = 0; i < rows_; ++i)
+      for (int j = 0; j < cols_; ++j) c[i*cols_ + j] = b.cell(i, j);
+  }
+  else for (Pos p : changes_[g].cells()) c[p.i*cols_ + p.j] = b.cell(p);
+  seq_[g] = b.events().head();
+
+  Unit* u = units_.data() + size_t(g)*nu_;
+  for (int id = 0; id < nu_; ++id) u[id] = b.unit(id);
+  for (int pl = 0; pl < np_; ++pl) {
+    num_cities_[g*np_ + pl] = b.num_cities(pl);
+    total_score_[g*np_ + pl] = b.total_score(pl);
+  }
+  round_[g] = b.round();
+  done_[g] = b.round() >= nr_;
+}
+
+
+void Env_batch::reset (int g, int seed) {
+  _my_assert(g >= 0 and g < n_, "Wrong game.");
+  boards_[g]->restart(seed);
+  sync(g, true);
+}
+
+
+int Env_batch::step (const Movement* moves, const int* counts) {
+  int k = 0;
+  for (int g = 0; g < n_; ++g) {
+    offset_[g] = k;
+    for (int pl = 0; pl < np_; ++pl) {
+      _my_assert(counts[g*np_ + pl] >= 0, "Negative number of movements.");
+      k += counts[g*np_ + pl];
+    }
+  }
+
+  pool_.parallel_for(n_, [&](int g) {
+    if (done_[g]) return;
+    const Movement* m = moves + offset_[g];
+    for (int pl = 0; pl < np_; ++pl) {
+      Action& a = actions_[g*np_ + pl];
+      int c = counts[g*np_ + pl];
+      Warnings::Scope w(boards_[g]->warnings_, pl);
+      a.clear();
+      a.command_all(View<Movement>(m, m + min(c, (int)Action::MAX_MOVEMENTS)));
+      m += c;
+    }
+    boards_[g]->next(act_[g], *null_[g]);
+    sync(g, false);
+  });
+
+  int running = 0;
+  for (int g = 0; g < n_; ++g) running += not done_[g];
+  return running;
+}
+
+
+void Env_batch::observe (int g, int pov, uint8_t* out) const {
+  encoders_[g].encode(*boards_[g], pov, out);
+}
+
+
+void Env_batch::observe (int g, int pov, float* out) const {
+  encoders_[g].encode(*boards_[g], pov, out);
+}
+
+
+void Env_batch::observe_all (int pov, uint8_t* out) {
+  size_t k = planes_size();
+  pool_.parallel_for(n_, [&](int g) { observe(g, pov, out + g*k); });
+}
+
+
+void Env_batch::observe_all (int pov, float* out) {
+  size_t k = planes_size();
+  pool_.parallel_for(n_, [&](int g) { observe(g, pov, out + g*k); });
+}
+
+
+struct madmax_env {
+  Env_batch batch;
+
+  madmax_env (int n, const char* config, int seed, int counter, int threads)
+    : batch(n, config, seed, counter ? CounterRng : LegacyRng, threads) { }
+};
+
+
+// message of the last call of this thread that failed, or empty
+static thread_local string last_error_;
+
+
+/**
+ * Notes msg as the last error, and returns -1.
+ */
+static int fail (const string& msg) {
+  last_error_ = msg;
+  return -1;
+}
+
+
+/**
+ * Checks e and a game index of it, noting the error if they are wrong.
+ */
+static bool game_ok (const madmax_env* e, int game) {
+  if (e == 0) last_error_ = "null environment";
+  else if (game < 0 or game >= e->batch.size())
+    last_error_ = "wrong game " + int_to_string(game);
+  else return true;
+  return false;
+}
+
+
+/**
+ * Checks e, a player pov and the output buffer of an observation.
+ */
+static bool observe_ok (const madmax_env* e, int pov, const void* out) {
+  if (e == 0) last_error_ = "null environment";
+  else if (pov < 0 or pov >= e->batch.nb_players())
+    last_error_ = "wrong player " + int_to_string(pov);
+  else if (out == 0) last_error_ = "null output buffer";
+  else return true;
+  return false;
+}
+
+
+const char* madmax_last_error () {
+  return last_error_.c_str();
+}
+
+
+madmax_env* madmax_create (int n, const char* config, int seed,
+                           int counter, int threads) {
+  if (n <= 0) last_error_ = "wrong number of games " + int_to_string(n);
+  else if (config == 0) last_error_ = "null config";
+  else if (threads < 0) last_error_ = "wrong number of threads";
+  else return new madmax_env(n, config, seed, counter, threads);
+  return 0;
+}
+
+
+void madmax_destroy (madmax_env* e) {
+  delete e;
+}
+
+
+int madmax_shape (const madmax_env* e, int* shape) {
+  if (e == 0) return fail("null environment");
+  if (shape == 0) return fail("null shape");
+  const Env_batch& b = e->batch;
+  shape[0] = b.size();
+  shape[1] = b.nb_players();
+  shape[2] = b.nb_units();
+  shape[3] = b.rows();
+  shape[4] = b.cols();
+  shape[5] = b.nb_rounds();
+  return 0;
+}
+
+
+int madmax_reset (madmax_env* e, int game, int seed) {
+  if (not game_ok(e, game)) return -1;
+  e->batch.reset(game, seed);
+  return 0;
+}
+
+
+int madmax_step (madmax_env* e, const int* moves, const int* counts) {
+  if (e == 0) return fail("null environment");
+  if (counts == 0) return fail("null counts");
+  const Env_batch& b = e->batch;
+  long long total = 0;
+  for (int k = 0; k < b.size()*b.nb_players(); ++k) {
+    if (counts[k] < 0)
+      return fail("negative count " + int_to_string(counts[k])
+                  + " at " + int_to_string(k));
+    total += counts[k];
+  }
+  if (total > 0 and moves == 0) return fail("null moves");
+  return e->batch.step((const Movement*)moves, counts);
+}
+
+
+const int* madmax_cells (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return 0;
+  return (const int*)e->batch.cells(game);
+}
+
+
+const int* madmax_units (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return 0;
+  return (const int*)e->batch.units(game);
+}
+
+
+const int* madmax_num_cities (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return 0;
+  return e->batch.num_cities(game);
+}
+
+
+const int* madmax_total_score (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return 0;
+  return e->batch.total_score(game);
+}
+
+
+int madmax_round (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return -1;
+  return e->batch.round(game);
+}
+
+
+int madmax_done (const madmax_env* e, int game) {
+  if (not game_ok(e, game)) return -1;
+  return e->batch.done(game);
+}
+
+
+int madmax_planes_size (const madmax_env* e) {
+  if (e == 0) return fail("null environment");
+  return e->batch.planes_size();
+}
+
+
+int madmax_observe (madmax_env* e, int pov, float* out) {
+  if (not observe_ok(e, pov, out)) return -1;
+  e->batch.observe_all(pov, out);
+  return 0;
+}
+
+
+int madmax_observe_bytes (madmax_env* e, int pov, unsigned char* out) {
+  if (not observe_ok(e, pov, out)) return -1;
+  e->batch.observe_all(pov, out);
+  return 0;
+}
@@ -0,0 +1,264 @@
+#ifndef Env_hh
+#define Env_hh
+
+
+#include "Board.hh"
+#include "Planes.hh"
+#include "Pool.hh"
+
+
+/** \file
+ * Contains the Env_batch class, which simulates many games in lockstep
+ * with actions given from outside, and its C interface. Both are built,
+ * with the rest of the simulation, into the library libmadmax.a.
+ */
+
+
+/**
+ * A batch of independent games with the same settings, stepped all at
+ * once with movements given by the caller, as a vectorized environment.
+ *
+ * The state of the games is kept in arrays preallocated when the batch
+ * is created, each with the data of all the games one after the other:
+ * the grids (row by row), the units, and the cities and scores of every
+ * player. After every step only the cells that changed are copied
+ * there, following the events of each board.
+ *
+ * Each game has its own seed and random generators, so that the results
+ * do not depend on how many threads step the batch. Games that reach
+ * their last round are done, and are not stepped until they are reset.
+ */
+class Env_batch {
+
+  int n_, np_, nu_, rows_, cols_, nr_;
+
+  vector< unique_ptr<Board> > boards_;
+  vector< unique_ptr<ostream> > null_;  // Streams that discard the replays.
+  vector<long long> seq_;               // First event not yet copied, per game.
+  vector<Changes> changes_;
+  vector<Action> actions_;              // Actions of every game and player.
+  vector< vector<const Action*> > act_; // The same, as passed to Board::next.
+  vector<int> offset_;                  // Start of each game in the movements.
+  vector<Plane_encoder> encoders_;      // One per game, for their scratch.
+
+  vector<Cell> cells_;
+  vector<Unit> units_;
+  vector<int> num_cities_, total_score_, round_, done_;
+
+  Worker_pool pool_;
+
+  /**
+   * Copies the state of game g to the arrays, only the changed cells
+   * unless all is true.
+   */
+  void sync (int g, bool all);
+
+public:
+
+  /**
+   * Creates n games from the configuration text config (as in
+   * default.cnf), with seeds seed, seed+1, ..., stepped by the given
+   * number of worker threads besides the calling one.
+   */
+  Env_batch (int n, const string& config, int seed,
+             RngKind rng = CounterRng, int threads = 0);
+
+  /**
+   * Returns the number of games.
+   */
+  inline int size () const {
+    return n_;
+  }
+
+  inline int nb_players () const {
+    return np_;
+  }
+
+  inline int nb_units () const {
+    return nu_;
+  }
+
+  inline int rows () const {
+    return rows_;
+  }
+
+  inline int cols () const {
+    return cols_;
+  }
+
+  inline int nb_rounds () const {
+    return nr_;
+  }
+
+  /**
+   * Starts game g again, with the given seed, on the same board
+   * (see Board::restart).
+   */
+  void reset (int g, int seed);
+
+  /**
+   * Plays a round of every game that is not done. The movements of each
+   * game and player come one after the other in moves, game by game and
+   * player by player, and counts (with size()*nb_players() entries) tells
+   * how many of them there are for each, none negative. Movements are
+   * checked as in a normal game. Returns the number of games that are
+   * not done.
+   */
+  int step (const Movement* moves, const int* counts);
+
+  /**
+   * Returns the board of game g, for any other query.
+   */
+  inline const Board& board (int g) const {
+    return *boards_[g];
+  }
+
+  /**
+   * Returns the grid of game g, rows()*cols() cells row by row.
+   */
+  inline const Cell* cells (int g) const {
+    return cells_.data() + size_t(g)*rows_*cols_;
+  }
+
+  /**
+   * Returns the nb_units() units of game g, by id.
+   */
+  inline const Unit* units (int g) const {
+    return units_.data() + size_t(g)*nu_;
+  }
+
+  /**
+   * Returns the number of cities of each player in game g.
+   */
+  inline const int* num_cities (int g) const {
+    return num_cities_.data() + g*np_;
+  }
+
+  /**
+   * Returns the total score of each player in game g.
+   */
+  inline const int* total_score (int g) const {
+    return total_score_.data() + g*np_;
+  }
+
+  /**
+   * Returns the current round of game g.
+   */
+  inline int round (int g) const {
+    return round_[g];
+  }
+
+  /**
+   * Returns whether game g has played all its rounds.
+   */
+  inline bool done (int g) const {
+    return done_[g];
+  }
+
+  /**
+   * Returns the number of values of the planes of a game.
+   */
+  inline int planes_size () const {
+    return encoders_[0].size();
+  }
+
+  /**
+   * Writes the planes of game g, seen from player pov, to out
+   * (see Plane_encoder). Game g is encoded with its own encoder, so
+   * different games may be observed at once, but not the same one.
+   */
+  void observe (int g, int pov, uint8_t* out) const;
+
+  /**
+   * Alias, with float values.
+   */
+  void observe (int g, int pov, float* out) const;
+
+  /**
+   * Writes the planes of all the games, one after the other, in parallel.
+   */
+  void observe_all (int pov, uint8_t* out);
+
+  /**
+   * Alias, with float values.
+   */
+  void observe_all (int pov, float* out);
+
+};
+
+
+/**
+ * C interface of Env_batch. Cells are three ints (type, owner, id),
+ * units seven (type, id, player, food, water, i, j), and movements two
+ * (id, direction), with the values of the enums in Structs.hh.
+ *
+ * The arguments are checked here rather than asserted: a call with a
+ * null environment or buffer, a wrong game or player, or a negative
+ * count does nothing and returns -1, or null for pointers, and
+ * madmax_last_error() tells why.
+ */
+extern "C" {
+
+  typedef struct madmax_env madmax_env;
+
+  /**
+   * Returns the message of the last call of this thread that failed,
+   * or an empty string.
+   */
+  const char* madmax_last_error ();
+
+  /**
+   * Returns a batch of n games, as the constructor of Env_batch.
+   * With counter != 0 the games use the counter random generator.
+   */
+  madmax_env* madmax_create (int n, const char* config, int seed,
+                             int counter, int threads);
+
+  void madmax_destroy (madmax_env* e);
+
+  /**
+   * Writes the size of the batch, and nb_players, nb_units, rows,
+   * cols and nb_rounds of its games. Returns 0.
+   */
+  int madmax_shape (const madmax_env* e, int* shape);
+
+  /**
+   * Restarts a game with a seed. Returns 0.
+   */
+  int madmax_reset (madmax_env* e, int game, int seed);
+
+  /**
+   * Steps the batch, as Env_batch::step. Returns -1, without stepping
+   * anything, if some count is negative.
+   */
+  int madmax_step (madmax_env* e, const int* moves, const int* counts);
+
+  const int* madmax_cells (const madmax_env* e, int game);
+
+  const int* madmax_units (const madmax_env* e, int game);
+
+  const int* madmax_num_cities (const madmax_env* e, int game);
+
+  const int* madmax_total_score (const madmax_env* e, int game);
+
+  int madmax_round (const madmax_env* e, int game);
+
+  int madmax_done (const madmax_env* e, int game);
+
+  /**
+   * Returns the number of values of the planes of a game.
+   */
+  int madmax_planes_size (const madmax_env* e);
+
+  /**
+   * Writes the planes of all the games, seen from player pov.
+   * Returns 0.
+   */
+  int madmax_observe (madmax_env* e, int pov, float* out);
+
+  int madmax_observe_bytes (madmax_env* e, int pov, unsigned char* out);
+
+}
+
+
+#endif
@@ -0,0 +1,23 @@
+#include "Event.hh"
+
+
+Event_stream::Event_stream (int capacity) : mask_(0), head_(0) {
+  int n = 1;
+  while (n < capacity) n <<= 1;
+  ring_ = vector<Event>(n);
+  mask_ = n - 1;
+}
+
+
+ostream& operator<< (ostream& os, const Event& e) {
+  static const char* names[EventTypeSize] = {
+    "moved", "attacked", "thunderdome", "captured", "starved",
+    "city_conquered", "food_recharged", "water_recharged",
+    "fuel_recharged", "spawned"
+  };
+  assert(e.type >= 0 and e.type < EventTypeSize);
+  return os << e.round << ' ' << names[e.type] << ' ' << e.id << ' '
+            << e.other << ' ' << e.player << ' ' << e.value << ' '
+            << e.from.i << ' ' << e.from.j << ' '
+            << e.to.i << ' ' << e.to.j;
+}
@@ -0,0 +1,211 @@
+#ifndef Event_hh
+#define Event_hh
+
+
+#include "Structs.hh"
+
+
+/** \file
+ * Contains the EventType enumeration, the Event struct and the
+ * Event_stream class, a fixed-size ring buffer of the events
+ * produced by Board while computing each round.
+ */
+
+
+/**
+ * Enum to encode the kinds of events.
+ */
+enum EventType {
+  Moved,          // A unit moved from one cell to another.
+  Attacked,       // A warrior attacked a warrior outside a thunderdome.
+  Thunderdome,    // Two warriors fought with both of them inside a city.
+  Captured,       // A unit changed its owner (and will be respawned).
+  Starved,        // A warrior ran out of food or water.
+  CityConquered,  // A city changed its owner.
+  FoodRecharged,  // A warrior ate in a city.
+  WaterRecharged, // A warrior drank next to water.
+  FuelRecharged,  // A car refueled next to a station.
+  Spawned,        // A captured unit was placed again on the board.
+  EventTypeSize
+};
+
+
+/**
+ * Describes something that happened during a round.
+ *
+ * The meaning of the fields depends on the type:
+ *   Moved:          id moved from `from` to `to`, player is its owner.
+ *   Attacked:       id attacked other, value is the food plus water taken.
+ *   Thunderdome:    id attacked other, value is the id of the winner.
+ *   Captured:       id now belongs to player, value is the previous owner,
+ *                   other is the unit that caused it (or -1).
+ *   Starved:        id of player starved at `from`.
+ *   CityConquered:  id is the city index, player the new owner,
+ *                   value the previous owner, `from` one of its cells.
+ *   *Recharged:     id of player gained value units of the resource.
+ *   Spawned:        id of player was placed at `to`.
+ */
+struct Event {
+
+  EventType type;
+  int round;
+  int id;
+  int other;
+  int player;
+  int value;
+  Pos from;
+  Pos to;
+
+  /**
+   * Default constructor.
+   */
+  inline Event () : type(Moved), round(-1), id(-1), other(-1),
+                    player(-1), value(0) { }
+
+  /**
+   * Given constructor.
+   */
+  inline Event (EventType t, int r, int id, int other, int pl, int v,
+                Pos from = Pos(-1, -1), Pos to = Pos(-1, -1))
+                : type(t), round(r), id(id), other(other),
+                  player(pl), value(v), from(from), to(to) { }
+
+};
+
+
+/**
+ * Ring buffer of events, allocated once.
+ *
+ * Every event gets a sequence number. Subscribers keep the sequence
+ * number of the next event they want to read and consume events
+ * with at() until head(). Events older than tail() have been
+ * overwritten; a subscriber that falls that far behind can detect it
+ * by comparing its position with tail().
+ */
+class Event_stream {
+
+  vector<Event> ring_;
+  long long mask_;
+  long long head_;
+
+public:
+
+  /**
+   * Constructor. The capacity is rounded up to a power of two.
+   */
+  explicit Event_stream (int capacity = 1<<13);
+
+  /**
+   * Appends an event, overwriting the oldest one if the buffer is full.
+   */
+  inline void emit (const Event& e) {
+    ring_[head_&mask_] = e;
+    ++head_;
+  }
+
+  /**
+   * Returns the sequence number that the next event will get.
+   */
+  inline long long head () const {
+    return head_;
+  }
+
+  /**
+   * Returns the sequence number of the oldest event still available.
+   */
+  inline long long tail () const {
+    return max(0LL, head_ - (long long)ring_.size());
+  }
+
+  /**
+   * Returns whether the event with sequence number seq is available.
+   */
+  inline bool seq_ok (long long seq) const {
+    return seq >= tail() and seq < head();
+  }
+
+  /**
+   * Returns the event with sequence number seq, which must be available.
+   */
+  inline const Event& at (long long seq) const {
+    assert(seq_ok(seq));
+    return ring_[seq&mask_];
+  }
+
+  /**
+   * Returns the maximum number of events that are kept.
+   */
+  inline int capacity () const {
+    return ring_.size();
+  }
+
+};
+
+
+/**
+ * Summary of what changed on the board between two points of the
+ * event stream, so that players can update their own data
+ * incrementally instead of rescanning the whole state.
+ */
+class Changes {
+
+  friend class Board;
+
+  bool all_;
+  vector<Pos> cells_;
+  vector<int> units_;
+  vector<int> cities_;
+
+  /**
+   * Used to list every cell, unit and city only once.
+   */
+  vector<int> cell_mark_, unit_mark_, city_mark_;
+  int stamp_;
+
+public:
+
+  /**
+   * Default constructor: everything changed.
+   */
+  Changes () : all_(true), stamp_(0) { }
+
+  /**
+   * Returns whether everything must be considered changed, because this
+   * is the first round or too many events happened to be tracked.
+   * In that case the lists below are empty.
+   */
+  inline bool all () const {
+    return all_;
+  }
+
+  /**
+   * Returns the cells whose unit id or owner changed.
+   */
+  inline const vector<Pos>& cells () const {
+    return cells_;
+  }
+
+  /**
+   * Returns the ids of the units that were captured (and thus respawned).
+   */
+  inline const vector<int>& units () const {
+    return units_;
+  }
+
+  /**
+   * Returns the indices of the cities that changed their owner.
+   */
+  inline const vector<int>& cities () const {
+    return cities_;
+  }
+
+};
+
+
+/**
+ * Prints an event in a single line.
+ */
+ostream& operator<< (ostream& os, const Event& e);
+
+
+#endif
@@ -1,12 +1,168 @@
 #include "Game.hh"
 
+#include <thread>
 
-void Game::run (vector<string> names, istream& is, ostream& os, int seed) {
-  cerr << "info: seed " << seed << endl;
 
-  cerr << "info: loading game" << endl;
-  Board b(is, seed);
-  cerr << "info: loaded game" << endl;
+bool Game::account_cpu (Board& b, int pl, double used, double total,
+                        Action& act, int committed,
+                        const Game_options& opt) {
+  bool over_round = opt.cpu_round > 0 and used > opt.cpu_round;
+  bool over_total = opt.cpu_total > 0 and total > opt.cpu_total;
+  if (over_total or (over_round and committed < 0)) {
+    _info("player " << b.name(pl) << " disqualified in round "
+          << b.round() << ": used " << (over_total ? total : used)
+          << " seconds of cpu " << (over_total ? "in total" : "in a round"));
+    b.cpu_status_[pl] = -1;
+    return false;
+  }
+
+  if (over_round) {
+    if (committed < (int)act.v_.size())
+      act.v_.erase(act.v_.begin() + committed, act.v_.end());
+    _info("player " << b.name(pl) << " went over its budget in round "
+          << b.round() << ": kept " << act.v_.size() << " committed movements");
+  }
+
+  double st = 0;
+  if (opt.cpu_total > 0) st = max(st, total/opt.cpu_total);
+  if (opt.cpu_round > 0) st = max(st, used/opt.cpu_round);
+  b.cpu_status_[pl] = min(st, 1.0);
+  return true;
+}
+
+
+Player_context& Game::prepare (Board& b, Player* p, const Query_cache& cache,
+                              const Combat& combat) {
+  Player_context& ctx = p->context();
+  b.changes_since(ctx.seq, ctx.changes);
+  ctx.seq = b.events().head();
+  p->reset(b, ctx.changes);
+  ctx.cache = &cache;
+  ctx.index = &b.unit_index();
+  ctx.combat = &combat;
+  ctx.committed = -1;
+  return ctx;
+}
+
+
+void Game::initialize (Board& b, const vector<Player*>& players,
+                       const vector<string>& names, const Query_cache& cache,
+                       const Combat& combat, const Game_options& opt) {
+  int np = players.size();
+  vector<Registry::Initializer> init(np);
+  vector<double> used(np, 0);
+
+  for (int pl = 0; pl < np; ++pl) {
+    init[pl] = Registry::initializer(names[pl]);
+    if (init[pl]) prepare(b, players[pl], cache, combat);
+  }
+
+  auto run_init = [&](int pl) {
+    Warnings::Scope w(b.warnings_, pl);
+    Player_context& ctx = players[pl]->context();
+    ctx.deadline.start(opt.cpu_init, 0, ctx.pool);
+    double start = thread_cpu_time();
+    init[pl](players[pl]);
+    ctx.pool->wait_idle();
+    used[pl] = thread_cpu_time() - start + ctx.pool->take_cpu();
+  };
+
+  if (opt.parallel_init) {
+    vector<thread> threads;
+    for (int pl = 0; pl < np; ++pl)
+      if (init[pl]) threads.push_back(thread(run_init, pl));
+    for (thread& t : threads) t.join();
+  }
+  else {
+    for (int pl = 0; pl < np; ++pl)
+      if (init[pl]) run_init(pl);
+  }
+
+  for (int pl = 0; pl < np; ++pl)
+    if (init[pl]) {
+      _info("player " << b.name(pl) << " initialized in " << used[pl]
+            << " seconds of cpu");
+      if (opt.cpu_init > 0 and used[pl] > opt.cpu_init) {
+        _info("player " << b.name(pl)
+              << " disqualified: went over the budget of init()");
+        b.cpu_status_[pl] = -1;
+      }
+    }
+}
+
+
+void Game::finish (const Board& b, const vector<double>& cpu_used,
+                   double start, Game_result& r) {
+  int np = b.nb_players();
+  r.rounds = b.round();
+  r.seconds = wall_time() - start;
+  r.names = b.names_;
+  r.cpu = cpu_used;
+  for (int pl = 0; pl < np; ++pl) r.score.push_back(b.total_score(pl));
+  r.upper = b.score_upper();
+  int top = *max_element(r.score.begin(), r.score.end());
+  for (int pl = 0; pl < np; ++pl) r.winner.push_back(r.score[pl] == top);
+}
+
+
+void Game_result::print_json (ostream& os) const {
+  int np = names.size();
+  os << "{\"seed\": " << seed << ", \"rounds\": " << rounds
+     << ", \"seconds\": " << seconds << ", \"players\": [";
+  for (int pl = 0; pl < np; ++pl) {
+    os << (pl ? ", " : "") << "{\"name\": \"" << names[pl]
+       << "\", \"score\": " << score[pl];
+    if (not upper.empty()) os << ", \"upper\": " << upper[pl];
+    os << ", \"winner\": " << (winner[pl] ? "true" : "false")
+       << ", \"cpu\": " << cpu[pl] << ", \"cities\": [";
+    for (int k = 0; k < (int)cities.size(); ++k)
+      os << (k ? ", " : "") << cities[k][pl];
+    os << "]}";
+  }
+  os << "]}" << endl;
+}
+
+
+void Game_result::print_csv (ostream& os, bool header) const {
+  if (header) os << "seed,rounds,seconds,player,name,score,winner,cpu,cities,upper" << endl;
+  for (int pl = 0; pl < (int)names.size(); ++pl) {
+    os << seed << ',' << rounds << ',' << seconds << ',' << pl << ','
+       << names[pl] << ',' << score[pl] << ',' << winner[pl] << ','
+       << cpu[pl] << ',';
+    for (int k = 0; k < (int)cities.size(); ++k)
+      os << (k ? " " : "") << cities[k][pl];
+    os << ',' << (upper.empty() ? score[pl] : upper[pl]) << endl;
+  }
+}
+
+
+void Game_result::save (const string& json, const string& csv) const {
+  if (not json.empty()) {
+    ofstream f(json.c_str(), ios::app);
+    _my_assert(f, "Cannot write " + json + ".");
+    print_json(f);
+  }
+  if (not csv.empty()) {
+    ofstream f(csv.c_str(), ios::app);
+    _my_assert(f, "Cannot write " + csv + ".");
+    print_csv(f, f.tellp() == 0);
+  }
+}
+
+
+Game_result Game::run (vector<string> names, istream& is, ostream& os,
+                       int seed, const Game_options& opt) {
+  double start = wall_time();
+  Game_result res;
+  res.seed = seed;
+  _info("seed " << seed);
+
+  _info("loading game");
+  Board b(is, seed, opt.rng);
+  _info("loaded game");
+
+  // the warnings noted in this thread are of this game
+  Warnings::Scope warnings(b.warnings_, -1);
 
   int np = b.nb_players();
   int nr = b.nb_rounds();
@@ -14,40 +170,139 @@ void Game::run (vector<string> names, istream& is, ostream& os, int seed) {
   _my_assert(np == (int)names.size(), "Wrong number of players.");
 
   vector<Player*> players;
+  vector< unique_ptr<Worker_pool> > pools;
   for (int pl = 0; pl < np; ++pl) {
     string name = names[pl];
     b.names_[pl] = name;
-    cerr << "info: loading player " << name << endl;
+    _info("loading player " << name);
     players.push_back(Registry::new_player(name));
     players[pl]->me_ = pl;
-    players[pl]->set_random_seed(seed + pl + 1);
+    players[pl]->set_random_seed(b.player_seed(pl));
     *static_cast<Settings*>(players[pl]) = (Settings)b;
+    pools.emplace_back(new Worker_pool(opt.threads));
+    Player_context& ctx = players[pl]->context();
+    ctx.pool = pools[pl].get();
+    ctx.task_key = Counter_rng::derive(b.player_seed(pl), PlayerStream);
   }
-  cerr << "info: players loaded" << endl;
+  _info("players loaded");
+
+  Query_cache cache(b);
+  Combat combat(b);
+  initialize(b, players, names, cache, combat, opt);
+
+  // headless games write their replay to a stream without buffer,
+  // which formats nothing
+  ostream null(0);
+  ostream& out = opt.headless ? null : os;
+  out << "Game" << endl << endl;
+  out << "Seed " << seed << endl << endl;
+  b.print_preamble(out);
+  b.print_names(out);
+  if (not opt.headless) b.print_state(out);
+
+  // players are borrowed as their actions, which are not copied
+  vector<const Action*> actions(np);
+  Action idle; // for disqualified players
+  vector<double> cpu_used(np, 0);
+
+  // background ponder() of each player, between its calls to play()
+  vector<Registry::Ponderer> ponderer(np);
+  for (int pl = 0; pl < np; ++pl)
+    if (opt.ponder) ponderer[pl] = Registry::ponderer(names[pl]);
+  vector<thread> pondering(np);
+  vector<double> pondered(np, 0);
 
-  os << "Game" << endl << endl;
-  os << "Seed " << seed << endl << endl;
-  b.print_preamble(os);
-  b.print_names(os);
-  b.print_state(os);
+  auto start_pondering = [&](int pl) {
+    if (not ponderer[pl] or b.cpu_status_[pl] < 0) return;
+    Player_context& ctx = players[pl]->context();
+    ctx.cache = 0; // they change while the player ponders
+    ctx.index = 0;
+    ctx.stop = false;
+    double left = opt.cpu_total > 0 ? opt.cpu_total - cpu_used[pl] : 0;
+    pondering[pl] = thread([&, pl, left] {
+      Warnings::Scope w(b.warnings_, pl);
+      Player_context& ctx = players[pl]->context();
+      ctx.deadline.start(0, left, ctx.pool);
+      double start = thread_cpu_time();
+      ponderer[pl](players[pl]);
+      ctx.pool->wait_idle();
+      pondered[pl] = thread_cpu_time() - start;
+    });
+  };
 
+  auto stop_pondering = [&](int pl) {
+    if (not pondering[pl].joinable()) return;
+    players[pl]->context().stop = true;
+    pondering[pl].join();
+    cpu_used[pl] += pondered[pl] + players[pl]->context().pool->take_cpu();
+  };
   for (int round = 0; round < nr; ++round) {
-    cerr << "info: start round " << round << endl;
-    vector<Action> actions(np);
+    _debug("start round " << round);
     for (int pl = 0; pl < np; ++pl) {
-      cerr << "info:     start player " << pl << endl;
-      players[pl]->reset(b);
+      stop_pondering(pl);
+      if (b.cpu_status_[pl] < 0) {
+        actions[pl] = &idle;
+        continue;
+      }
+      _debug("    start player " << pl);
+      Player_context& ctx = prepare(b, players[pl], cache, combat);
+      ctx.deadline.start(opt.cpu_round,
+                         opt.cpu_total > 0 ? opt.cpu_total - cpu_used[pl] : 0,
+                         ctx.pool);
+      Warnings::set_player(pl);
+      double start = thread_cpu_time();
       players[pl]->play();
-      actions[pl] = *players[pl];
-      cerr << "info:     end player " << pl << endl;
+      ctx.pool->wait_idle(); // no task may run while the board changes
+      double used = thread_cpu_time() - start + ctx.pool->take_cpu();
+      Warnings::set_player(-1);
+      cpu_used[pl] += used;
+      actions[pl] = players[pl];
+      if (not account_cpu(b, pl, used, cpu_used[pl], *players[pl],
+                          ctx.committed, opt))
+        actions[pl] = &idle;
+      start_pondering(pl);
+      _debug("    end player " << pl);
     }
 
-    b.next(actions, os);
-    b.print_state(os);
-    cerr << "info: end round " << round << endl;
+    b.next(actions, out);
+    res.cities.push_back(b.num_cities_);
+    if (not opt.headless) b.print_state(out);
+    _debug("end round " << round);
+
+    vector<int> lower, upper;
+    if (opt.stop_when_decided and round + 1 < nr
+        and b.result_decided(lower, upper)) {
+      _info("result decided at round " << round);
+      for (int pl = 0; pl < np; ++pl) {
+        if (lower[pl] == upper[pl])
+          _info("player " << b.name(pl)
+                << " projected score " << lower[pl]);
+        else
+          _info("player " << b.name(pl)
+                << " score between " << lower[pl]
+                << " and " << upper[pl]);
+      }
+      b.decide(lower, upper);
+      break;
+    }
   }
 
+  for (int pl = 0; pl < np; ++pl) stop_pondering(pl);
+
+  // the results come last but one, where scripts look for them
+  b.warnings_.print_summary(b.names_);
+  for (int pl = 0; pl < np; ++pl)
+    _info("player " << b.name(pl) << " used " << cpu_used[pl]
+          << " seconds of cpu");
   b.print_results();
 
-  cerr << "info: game played" << endl;
+  // before their library can be reloaded for the next game
+  for (int pl = 0; pl < np; ++pl) {
+    players[pl]->release_context();
+    Registry::delete_player(names[pl], players[pl]);
+  }
+
+  finish(b, cpu_used, start, res);
+  _info("game played");
+  return res;
 }
@@ -6,14 +6,117 @@
 #include "Board.hh"
 
 
+/**
+ * Options of a game that can be set from the command line.
+ */
+struct Game_options {
+
+  bool stop_when_decided; // Stop as soon as the winner cannot change.
+  RngKind rng;            // Random generator of the board.
+  double cpu_total;       // Cpu seconds per player for the game, or 0.
+  double cpu_round;       // Cpu seconds per player and round, or 0.
+  double cpu_init;        // Cpu seconds per player for init(), or 0.
+  bool parallel_init;     // Run the init() of all players in parallel.
+  bool ponder;            // Let players ponder between their turns.
+  int threads;            // Worker threads of each player.
+  bool headless;          // No replay.
+
+  Game_options ()
+    : stop_when_decided(false), rng(LegacyRng), cpu_total(0), cpu_round(0),
+      cpu_init(0), parallel_init(false), ponder(false), threads(0),
+      headless(false) { }
+
+};
+
+
+/**
+ * Results of a game, for programs and scripts.
+ */
+struct Game_result {
+
+  int seed;                     // Seed of the game.
+  int rounds;                   // Rounds played.
+  double seconds;               // Wall time of the game.
+  vector<string> names;         // Names of the players.
+  vector<int> score;            // Total score of each player.
+  vector<int> upper;            // Upper bound of each score, if only bounds
+                                // are known (the scores are the lower ones).
+  vector<bool> winner;          // Whether each player got the top score.
+  vector<double> cpu;           // Cpu seconds used by each player.
+  vector< vector<int> > cities; // Cities of each player after every round.
+
+  /**
+   * Prints the results as a JSON object in a single line.
+   */
+  void print_json (ostream& os) const;
+
+  /**
+   * Prints the results as CSV, a line for each player, with the cities
+   * after every round separated by spaces, and the upper bound of the
+   * score last (the score itself if it is exact). Prints a header line
+   * first if header is true.
+   */
+  void print_csv (ostream& os, bool header) const;
+
+  /**
+   * Appends the results to a file of JSON lines and to a CSV file (with
+   * a header if it is new), unless their names are empty.
+   */
+  void save (const string& json, const string& csv) const;
+
+};
+
+
 /**
  * Game class.
  */
 class Game {
 
+  friend class SecGame;
+
+  /**
+   * Updates the cpu status of player pl, who used the given cpu time in
+   * this round and total in the game, and whose action is act. If the
+   * player went over the budget of the round but committed movements
+   * before (committed >= 0), only those are kept. Returns false, and
+   * disqualifies the player, if it went over the budget otherwise.
+   */
+  static bool account_cpu (Board& b, int pl, double used, double total,
+                           Action& act, int committed,
+                           const Game_options& opt);
+
+  /**
+   * Brings player p up to date with the board and its helpers,
+   * before calling one of its methods. Returns its context.
+   */
+  static Player_context& prepare (Board& b, Player* p, const Query_cache& cache,
+                                  const Combat& combat);
+
+  /**
+   * Calls the init() method of the players that have one (see Registry),
+   * before round 0. It has its own budget, and does not count towards the
+   * budget of the game. Players that go over it are disqualified.
+   */
+  static void initialize (Board& b, const vector<Player*>& players,
+                          const vector<string>& names,
+                          const Query_cache& cache, const Combat& combat,
+                          const Game_options& opt);
+
+  /**
+   * Fills the final results of the game on board b, which started at
+   * wall time start. The cities of every round are already in r.
+   */
+  static void finish (const Board& b, const vector<double>& cpu_used,
+                      double start, Game_result& r);
+
 public:
 
-  static void run (vector<string> names, istream& is, ostream& os, int seed);
+  /**
+   * Plays a game, writing its replay to os unless opt.headless,
+   * and returns its results.
+   */
+  static Game_result run (vector<string> names, istream& is, ostream& os,
+                          int seed, const Game_options& opt = Game_options());
 
 };
 
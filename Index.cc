@@ -0,0 +1,105 @@
+#include "Index.hh"
+
+
+void Unit_index::reset (int rows, int cols, int nb_players) {
+  rows_ = rows;
+  cols_ = cols;
+  words_ = (cols + 63)/64;
+  np_ = nb_players;
+  bits_.assign(np_*UnitTypeSize*rows_*words_, 0);
+}
+
+
+Unit_index::Range Unit_index::inside (Pos a, Pos b, int players,
+                                      UnitType t) const {
+  int i0 = max(a.i, 0), i1 = min(b.i, rows_ - 1);
+  int j0 = max(a.j, 0), j1 = min(b.j, cols_ - 1);
+
+  Range r;
+  Iterator& e = r.e_;
+  e.x_ = this;
+  e.i_ = i1 + 1;
+  e.i1_ = i1;
+  e.j0_ = j0;
+  e.j1_ = j1;
+  e.w_ = 0;
+  e.players_ = players;
+  e.t_ = t;
+  e.cur_ = 0;
+
+  r.b_ = e;
+  if (i0 > i1 or j0 > j1) return r;
+
+  Iterator& it = r.b_;
+  it.i_ = i0;
+  it.w_ = j0/64;
+  it.cur_ = word(i0, it.w_, j0, j1, players, t);
+  it.advance();
+  return r;
+}
+
+
+int Unit_index::count (Pos a, Pos b, int players, UnitType t) const {
+  int i0 = max(a.i, 0), i1 = min(b.i, rows_ - 1);
+  int j0 = max(a.j, 0), j1 = min(b.j, cols_ - 1);
+  int n = 0;
+  for (int i = i0; i <= i1; ++i)
+    for (int w = j0/64; j0 <= j1 and w <= j1/64; ++w)
+      n += __builtin_popcountll(word(i, w, j0, j1, players, t));
+  return n;
+}
+
+
+int Unit_index::nearest (Pos p, int k, int players, UnitType t, Pos* out,
+                         int max_r) const {
+  int n = 0;
+  int last = min(max_r, max(rows_, cols_));
+  for (int r = 0; n < k and r <= last; ++r) {
+    // the ring at distance exactly r: top and bottom rows, then the sides
+    Range strips[4] = {
+      inside(p + Pos(-r, -r), p + Pos(-r, r), players, t),
+      inside(p + Pos(r, -r), p + Pos(r, r), players, t),
+      inside(p + Pos(1 - r, -r), p + Pos(r - 1, -r), players, t),
+      inside(p + Pos(1 - r, r), p + Pos(r - 1, r), players, t)
+    };
+    int q = (r == 0 ? 1 : 4);
+    for (int s = 0; s < q; ++s)
+      for (Pos x : strips[s]) {
+        if (n == k) return n;
+        out[n++] = x;
+      }
+  }
+  return n;
+}
+
+
+void Unit_index::close_cells (int r, vector<uint64_t>& out,
+                              vector<uint64_t>& tmp) const {
+  int nw = words_;
+  vector<uint64_t>& occ = out;
+  occ.assign(rows_*nw, 0);
+  for (int pl = 0; pl < np_; ++pl)
+    for (int t = 0; t < UnitTypeSize; ++t)
+      for (int i = 0; i < rows_; ++i)
+        for (int w = 0; w < nw; ++w) occ[i*nw + w] |= row(pl, UnitType(t), i)[w];
+
+  // spreads every row r columns to each side, across words
+  vector<uint64_t>& h = tmp;
+  h.assign(occ.begin(), occ.end());
+  for (int i = 0; i < rows_; ++i)
+    for (int w = 0; w < nw; ++w) {
+      const uint64_t* x = &occ[i*nw];
+      uint64_t& d = h[i*nw + w];
+      for (int s = 1; s <= r and s < 64; ++s) {
+        d |= (x[w] << s) | (x[w] >> s);
+        if (w > 0) d |= x[w - 1] >> (64 - s);
+        if (w + 1 < nw) d |= x[w + 1] << (64 - s);
+      }
+    }
+
+  // and then r rows up and down
+  out.assign(rows_*nw, 0);
+  for (int i = 0; i < rows_; ++i)
+    for (int k = max(0, i - r); k <= min(rows_ - 1, i + r); ++k)
+      for (int w = 0; w < nw; ++w) out[i*nw + w] |= h[k*nw + w];
+}
@@ -0,0 +1,196 @@
+#ifndef Index_hh
+#define Index_hh
+
+
+#include "Structs.hh"
+#include <cstdint>
+
+
+/** \file
+ * Contains a spatial index of the units on the board.
+ */
+
+
+/**
+ * Spatial index of units, stored as one bitboard per player and unit
+ * type: every row of the board is a sequence of 64-bit words, with the
+ * bit of column j set if there is a unit at that column.
+ *
+ * Queries take a set of players as a bit mask (bit pl for player pl)
+ * and use Chebyshev distance, the number of moves between two cells.
+ * Results are given as positions; the unit is cell(p).id.
+ * No query allocates memory.
+ */
+class Unit_index {
+
+  int rows_, cols_, words_, np_;
+  vector<uint64_t> bits_;
+
+  /**
+   * Returns the first word of row i for player pl and type t.
+   */
+  inline const uint64_t* row (int pl, UnitType t, int i) const {
+    return &bits_[((pl*UnitTypeSize + t)*rows_ + i)*words_];
+  }
+
+  inline uint64_t* row (int pl, UnitType t, int i) {
+    return &bits_[((pl*UnitTypeSize + t)*rows_ + i)*words_];
+  }
+
+  /**
+   * Returns the bits of word w of row i for the players in mask,
+   * restricted to the columns in [j0, j1].
+   */
+  inline uint64_t word (int i, int w, int j0, int j1,
+                        int players, UnitType t) const {
+    int lo = max(j0 - 64*w, 0);
+    int hi = min(j1 - 64*w, 63);
+    if (lo > hi) return 0;
+    uint64_t m = (hi == 63 ? ~0ULL : (1ULL << (hi + 1)) - 1) & ~((1ULL << lo) - 1);
+    uint64_t x = 0;
+    for (int pl = 0; pl < np_; ++pl)
+      if (players >> pl & 1) x |= row(pl, t, i)[w];
+    return x & m;
+  }
+
+public:
+
+  /**
+   * Iterates over the positions of the units inside a rectangle.
+   */
+  class Iterator {
+
+    friend class Unit_index;
+
+    const Unit_index* x_;
+    int i_, i1_, j0_, j1_, w_, players_;
+    UnitType t_;
+    uint64_t cur_;
+
+    /**
+     * Moves to the next nonempty word, or to the end.
+     */
+    inline void advance () {
+      while (cur_ == 0) {
+        if (++w_ > j1_/64) {
+          w_ = j0_/64;
+          if (++i_ > i1_) {
+            w_ = 0;
+            return;
+          }
+        }
+        cur_ = x_->word(i_, w_, j0_, j1_, players_, t_);
+      }
+    }
+
+  public:
+
+    inline Pos operator* () const {
+      return Pos(i_, 64*w_ + __builtin_ctzll(cur_));
+    }
+
+    inline Iterator& operator++ () {
+      cur_ &= cur_ - 1;
+      advance();
+      return *this;
+    }
+
+    inline bool operator!= (const Iterator& o) const {
+      return i_ != o.i_ or w_ != o.w_ or cur_ != o.cur_;
+    }
+
+  };
+
+  /**
+   * A range of positions, to be used in range-based for loops.
+   */
+  class Range {
+
+    friend class Unit_index;
+
+    Iterator b_, e_;
+
+  public:
+
+    inline Iterator begin () const {
+      return b_;
+    }
+
+    inline Iterator end () const {
+      return e_;
+    }
+
+  };
+
+  /**
+   * Default constructor, with an empty index.
+   */
+  Unit_index () : rows_(0), cols_(0), words_(0), np_(0) { }
+
+  /**
+   * Clears the index for a board of the given size and players.
+   */
+  void reset (int rows, int cols, int nb_players);
+
+  /**
+   * Adds a unit of player pl and type t at p.
+   */
+  inline void add (int pl, UnitType t, Pos p) {
+    row(pl, t, p.i)[p.j/64] |= 1ULL << (p.j%64);
+  }
+
+  /**
+   * Removes a unit of player pl and type t from p.
+   */
+  inline void remove (int pl, UnitType t, Pos p) {
+    row(pl, t, p.i)[p.j/64] &= ~(1ULL << (p.j%64));
+  }
+
+  /**
+   * Returns the mask with all the players except pl.
+   */
+  inline int enemies (int pl) const {
+    return ((1 << np_) - 1) & ~(1 << pl);
+  }
+
+  /**
+   * Returns the units of the players in mask and of type t inside the
+   * rectangle with corners a and b (both included), in row-major order.
+   */
+  Range inside (Pos a, Pos b, int players, UnitType t) const;
+
+  /**
+   * Returns the units of the players in mask and of type t
+   * at distance at most r from p, in row-major order.
+   */
+  inline Range within (Pos p, int r, int players, UnitType t) const {
+    return inside(p + Pos(-r, -r), p + Pos(r, r), players, t);
+  }
+
+  /**
+   * Returns the number of units of the players in mask and of type t
+   * inside the rectangle with corners a and b (both included).
+   */
+  int count (Pos a, Pos b, int players, UnitType t) const;
+
+  /**
+   * Stores in out the positions of (at most) the k units of the players
+   * in mask and of type t nearest to p, by increasing distance.
+   * Only units at distance at most max_r are considered.
+   * Returns how many were found; out must have room for k positions.
+   */
+  int nearest (Pos p, int k, int players, UnitType t, Pos* out,
+               int max_r = 1000000) const;
+
+  /**
+   * Stores in out, row by row with (cols + 63)/64 words per row, the bits
+   * of the cells at distance at most r from some unit of any player and
+   * type. tmp is scratch space, which the caller keeps from one call to
+   * the next so that nothing is allocated once both have grown.
+   */
+  void close_cells (int r, vector<uint64_t>& out, vector<uint64_t>& tmp) const;
+
+};
+
+
+#endif
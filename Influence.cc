@@ -0,0 +1,79 @@
+#include "Influence.hh"
+
+
+const int Influence::INF;
+
+
+void Influence::compute (const Info& info, UnitType t) {
+  rows_ = info.rows();
+  cols_ = info.cols();
+  np_ = info.nb_players();
+  int n = rows_*cols_;
+
+  // cost of entering each cell, or 0 if units of type t cannot
+  cost_.resize(n);
+  for (int i = 0; i < rows_; ++i)
+    for (int j = 0; j < cols_; ++j) {
+      CellType ct = info.cell(i, j).type;
+      int c = 0;
+      if (t == Warrior) c = (ct == Desert or ct == Road or ct == City);
+      else if (ct == Road) c = 1;
+      else if (ct == Desert) c = np_;
+      cost_[i*cols_ + j] = c;
+    }
+
+  dist_.assign(n*np_, INF);
+  unit_.assign(n*np_, -1);
+  owner_.assign(n, -1);
+
+  // bucket queue of states pl*n + cell; costs are at most np_
+  int nb = np_ + 1;
+  buckets_.resize(nb);
+  for (vector<int>& b : buckets_) b.clear();
+  int pending = 0;
+  for (int id = 0; id < info.nb_units(); ++id) {
+    Unit u = info.unit(id);
+    if (u.type != t) continue;
+    int s = u.player*n + u.pos.i*cols_ + u.pos.j;
+    dist_[s] = 0;
+    unit_[s] = id;
+    buckets_[0].push_back(s);
+    ++pending;
+  }
+
+  for (int d = 0; pending > 0; ++d) {
+    vector<int>& b = buckets_[d%nb];
+    for (int k = 0; k < (int)b.size(); ++k) {
+      int s = b[k];
+      --pending;
+      if (dist_[s] != d) continue;
+      int pl = s/n;
+      int i = (s%n)/cols_;
+      int j = s%cols_;
+      for (int dir = 0; dir < 8; ++dir) {
+        Pos p = Pos(i, j) + Dir(dir);
+        if (p.i < 0 or p.i >= rows_ or p.j < 0 or p.j >= cols_) continue;
+        int c = cost_[p.i*cols_ + p.j];
+        int s2 = pl*n + p.i*cols_ + p.j;
+        if (c == 0 or d + c >= dist_[s2]) continue;
+        dist_[s2] = d + c;
+        unit_[s2] = unit_[s];
+        buckets_[(d + c)%nb].push_back(s2);
+        ++pending;
+      }
+    }
+    b.clear();
+  }
+
+  for (int x = 0; x < n; ++x) {
+    int best = INF;
+    for (int pl = 0; pl < np_; ++pl) {
+      int d = dist_[pl*n + x];
+      if (d < best) {
+        best = d;
+        owner_[x] = pl;
+      }
+      else if (d == best) owner_[x] = -1;
+    }
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef Influence_hh
+#define Influence_hh
+
+
+#include "Info.hh"
+
+
+/** \file
+ * Contains a class to compute, for every cell, the nearest unit
+ * of every player and the player that controls the cell.
+ */
+
+
+/**
+ * Influence fields of the units of one type.
+ *
+ * Distances are movement costs following the rules of the game:
+ * warriors move through Desert, Road and City cells at cost 1, and cars
+ * move through Road cells at cost 1 and Desert cells at cost nb_players()
+ * (since a car on the desert only moves in the rounds of its player).
+ * All the fields are computed by a single sweep from every unit at once,
+ * labelled by player, using a bucket queue.
+ *
+ * The results are stored in flat arrays with one plane per player:
+ * the entry of player pl and cell (i, j) is at pl*rows*cols + i*cols + j.
+ */
+class Influence {
+
+  int rows_, cols_, np_;
+  vector<int> cost_;
+  vector<int> dist_;
+  vector<int> unit_;
+  vector<int> owner_;
+  vector<vector<int>> buckets_;
+
+public:
+
+  /**
+   * Distance of the cells that no unit of a player can reach.
+   */
+  static const int INF = 100000000;
+
+  /**
+   * Default constructor, with no fields.
+   */
+  Influence () : rows_(0), cols_(0), np_(0) { }
+
+  /**
+   * Computes the fields for the units of type t.
+   */
+  void compute (const Info& info, UnitType t);
+
+  /**
+   * Returns the cost for the nearest unit of player pl to reach p, or INF.
+   */
+  inline int distance (int pl, Pos p) const {
+    return dist_[(pl*rows_ + p.i)*cols_ + p.j];
+  }
+
+  /**
+   * Returns the id of the nearest unit of player pl to p, or -1.
+   */
+  inline int nearest (int pl, Pos p) const {
+    return unit_[(pl*rows_ + p.i)*cols_ + p.j];
+  }
+
+  /**
+   * Returns the player strictly nearest to p, or -1 if there is a tie
+   * or no player can reach p (the Voronoi territory of each player).
+   */
+  inline int owner (Pos p) const {
+    return owner_[p.i*cols_ + p.j];
+  }
+
+  /**
+   * Returns the flat array of distances.
+   */
+  inline const vector<int>& distances () const {
+    return dist_;
+  }
+
+  /**
+   * Returns the flat array of nearest units.
+   */
+  inline const vector<int>& nearest_units () const {
+    return unit_;
+  }
+
+  /**
+   * Returns the flat array of owners, indexed by i*cols + j.
+   */
+  inline const vector<int>& owners () const {
+    return owner_;
+  }
+
+};
+
+
+#endif
@@ -78,6 +78,22 @@ public:
     }
   }
 
+  /**
+   * Returns the number of warnings of player pl for reason t
+   * since the beginning of the game.
+   */
+  inline int warnings (int pl, WarningType t) const {
+    return Warnings::count(pl, t);
+  }
+
+  /**
+   * Returns the number of warnings of player pl
+   * since the beginning of the game.
+   */
+  inline int warnings (int pl) const {
+    return Warnings::count(pl);
+  }
+
 };
 
 
@@ -0,0 +1,288 @@
+#include "Log.hh"
+#include "Utils.hh"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+atomic<int> Log::level_(LogInfo);
+
+
+namespace {
+
+  /**
+   * A buffer where a thread formats its messages, reused from one to the
+   * next so that formatting allocates nothing once it has grown.
+   */
+  class Line_buf : public streambuf {
+
+  public:
+
+    string s;
+    ostream os;
+
+    Line_buf () : os(this) { }
+
+  protected:
+
+    int overflow (int c) {
+      if (c != EOF) s += char(c);
+      return c;
+    }
+
+    streamsize xsputn (const char* p, streamsize n) {
+      s.append(p, n);
+      return n;
+    }
+
+  };
+
+
+  /**
+   * The ring where a thread appends its lines, emptied by whoever flushes.
+   * There is one writer and one reader (holding the lock of the log), so
+   * both positions only grow, and each is written by one side only.
+   */
+  struct Ring {
+    static const size_t SIZE = 1 << 16;
+    char data[SIZE];
+    atomic<size_t> head;  // Bytes written.
+    atomic<size_t> tail;  // Bytes read.
+    atomic<bool> dead;    // Whether the thread has finished.
+
+    Ring () : head(0), tail(0), dead(false) { }
+  };
+
+
+  /**
+   * The rings of all the threads and the thread that flushes them.
+   * It is never destroyed, since threads may log until the very end.
+   */
+  struct State {
+    mutex m;                    // Protects rings, and reading them.
+    vector< shared_ptr<Ring> > rings;
+    mutex wake_m;
+    condition_variable wake;
+    atomic<bool> pending;       // Whether something was logged meanwhile.
+
+    State () : pending(false) { }
+  };
+
+  State& state () {
+    static State* s = new State();
+    return *s;
+  }
+
+
+  /**
+   * Writes n bytes from p and then m bytes from q to the standard error,
+   * in one call if possible, so that other processes writing there do
+   * not break the lines.
+   */
+  void write_all (const char* p, size_t n, const char* q, size_t m) {
+    while (n + m > 0) {
+      iovec v[2] = { { (void*)p, n }, { (void*)q, m } };
+      ssize_t k = ::writev(2, v, 2);
+      if (k <= 0) return;
+      size_t kn = min(size_t(k), n);
+      p += kn;
+      n -= kn;
+      q += k - kn;
+      m -= k - kn;
+    }
+  }
+
+
+  /**
+   * Writes what is in the rings. The lock of the log must be held.
+   */
+  void drain (State& st) {
+    for (const shared_ptr<Ring>& r : st.rings) {
+      size_t t = r->tail.load(memory_order_relaxed);
+      size_t h = r->head.load();
+      if (t == h) continue;
+      size_t a = t%Ring::SIZE, b = h%Ring::SIZE;
+      if (a < b) write_all(r->data + a, b - a, 0, 0);
+      else write_all(r->data + a, Ring::SIZE - a, r->data, b);
+      r->tail.store(h, memory_order_release);
+    }
+  }
+
+
+  void drain_and_clean () {
+    State& st = state();
+    lock_guard<mutex> l(st.m);
+    drain(st);
+    auto gone = [](const shared_ptr<Ring>& r) {
+      return r->dead and r->tail == r->head;
+    };
+    st.rings.erase(remove_if(st.rings.begin(), st.rings.end(), gone),
+                   st.rings.end());
+  }
+
+
+  /**
+   * Main loop of the thread that flushes: it waits for something to be
+   * logged, lets some more lines come, and writes them all at once.
+   */
+  void flusher () {
+    State& st = state();
+    while (true) {
+      {
+        unique_lock<mutex> l(st.wake_m);
+        st.wake.wait(l, [&st] { return st.pending.load(); });
+      }
+      this_thread::sleep_for(chrono::milliseconds(10));
+      st.pending = false;
+      drain_and_clean();
+    }
+  }
+
+
+  /**
+   * Writes what is pending when the process aborts (for instance, after
+   * a failed _my_assert), unless the log is being written already.
+   */
+  void on_abort (int) {
+    State& st = state();
+    if (not st.m.try_lock()) return;
+    drain(st);
+    st.m.unlock();
+  }
+
+
+  void start () {
+    thread(flusher).detach();
+    signal(SIGABRT, on_abort);
+    atexit(Log::flush);
+  }
+
+
+  /**
+   * The ring of a thread, made when it first logs, and left to the
+   * flusher when the thread finishes.
+   */
+  struct Owner {
+    shared_ptr<Ring> r;
+
+    ~Owner () {
+      if (r) r->dead = true;
+    }
+  };
+
+  thread_local Owner owner;
+
+  Ring& ring () {
+    if (not owner.r) {
+      static once_flag once;
+      call_once(once, start);
+      owner.r = make_shared<Ring>();
+      State& st = state();
+      lock_guard<mutex> l(st.m);
+      st.rings.push_back(owner.r);
+    }
+    return *owner.r;
+  }
+
+
+  /**
+   * Wakes the flusher, unless it has been woken already.
+   */
+  void wake (State& st) {
+    if (st.pending.exchange(true)) return;
+    {
+      lock_guard<mutex> l(st.wake_m);
+    }
+    st.wake.notify_one();
+  }
+
+
+  /**
+   * Appends n bytes to the ring of the calling thread, waiting for room
+   * for all of them. Only messages longer than the ring are split.
+   */
+  void put (const char* p, size_t n) {
+    State& st = state();
+    Ring& r = ring();
+    size_t h = r.head.load(memory_order_relaxed);
+    while (n > 0) {
+      size_t k = min(n, Ring::SIZE);
+      if (k > Ring::SIZE - (h - r.tail.load(memory_order_acquire))) {
+        wake(st);
+        this_thread::yield();
+        continue;
+      }
+      size_t a = h%Ring::SIZE;
+      size_t k1 = min(k, Ring::SIZE - a);
+      memcpy(r.data + a, p, k1);
+      memcpy(r.data, p + k1, k - k1);
+      h += k;
+      p += k;
+      n -= k;
+      // sequentially consistent, against the flusher clearing pending:
+      // either it sees these bytes or this thread sees pending cleared
+      r.head.store(h);
+    }
+    if (not st.pending.load()) wake(st);
+  }
+
+
+  // one buffer for each message being formatted in the thread, since
+  // formatting a message may log another one
+  thread_local vector< unique_ptr<Line_buf> > bufs;
+  thread_local int depth = 0;
+
+  const char* prefix[LogLevelSize] = { "ERROR: ", "warning: ", "info: ", "debug: " };
+
+  inline Line_buf& buf () {
+    return *bufs[depth - 1];
+  }
+
+}
+
+
+Log::Line::Line (LogLevel l) : l_(l) {
+  if (int(bufs.size()) == depth++) bufs.emplace_back(new Line_buf());
+  Line_buf& b = buf();
+  b.s = prefix[l];
+  // formats set by the previous message do not last
+  b.os.flags(ios::dec | ios::skipws);
+  b.os.precision(6);
+  b.os.fill(' ');
+}
+
+
+Log::Line::~Line () {
+  string& s = buf().s;
+  s += '\n';
+  put(s.data(), s.size());
+  --depth;
+  if (l_ <= LogWarning) flush();
+}
+
+
+ostream& Log::Line::stream () {
+  return buf().os;
+}
+
+
+LogLevel Log::parse (const string& name) {
+  for (int l = 0; l < LogLevelSize; ++l)
+    if (name == Log::name(LogLevel(l))) return LogLevel(l);
+  return LogLevelSize;
+}
+
+
+const char* Log::name (LogLevel l) {
+  static const char* names[LogLevelSize] = { "error", "warning", "info", "debug" };
+  return names[l];
+}
+
+
+void Log::flush () {
+  drain_and_clean();
+}
@@ -0,0 +1,136 @@
+#ifndef Log_hh
+#define Log_hh
+
+
+// not Utils.hh, which includes this file for _my_assert
+#include <atomic>
+#include <iostream>
+#include <string>
+
+
+/** \file
+ * Contains the LogLevel enumeration, the Log class and the macros that
+ * write messages to the log of the game: _error, _warning, _info and
+ * _debug.
+ */
+
+
+/**
+ * Enum to encode the levels of messages, from the most to the least
+ * important.
+ */
+enum LogLevel {
+  LogError,
+  LogWarning,
+  LogInfo,
+  LogDebug,
+  LogLevelSize
+};
+
+
+/**
+ * Least important level compiled in: messages of less important levels
+ * are removed by the compiler (see the LOG_LEVEL option of the Makefile).
+ */
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LogDebug
+#endif
+
+
+/**
+ * Writes a message of level l, given as the operands of <<, and ended
+ * with a new line. The operands are only evaluated if the level is on.
+ */
+#define _log(l, x) do {                                         \
+    if ((l) <= LOG_MAX_LEVEL and Log::enabled(l)) {             \
+      Log::Line _log_line(l);                                   \
+      _log_line.stream() << x;                                  \
+    }                                                           \
+  } while (0)
+
+#define _error(x)   _log(LogError,   x)
+#define _warning(x) _log(LogWarning, x)
+#define _info(x)    _log(LogInfo,    x)
+#define _debug(x)   _log(LogDebug,   x)
+
+
+/**
+ * The log of the process, written to the standard error.
+ *
+ * Messages are only formatted if their level is enabled, which costs
+ * one relaxed atomic load otherwise. Each thread formats its messages
+ * in a buffer of its own, and appends them to a ring of its own without
+ * locks; a background thread moves the rings to the standard error
+ * every few milliseconds. Lines are never mixed, and the lines of a
+ * thread keep their order; the lines of different threads may not.
+ *
+ * Errors and warnings are written at once, with everything logged
+ * before them, and so is everything still pending at exit or abort.
+ */
+class Log {
+
+  static std::atomic<int> level_;
+
+public:
+
+  /**
+   * Formats a message, and logs it when destroyed.
+   */
+  class Line {
+
+    LogLevel l_;
+
+  public:
+
+    explicit Line (LogLevel l);
+
+    ~Line ();
+
+    /**
+     * Returns the stream where the message is formatted.
+     */
+    std::ostream& stream ();
+
+  };
+
+  /**
+   * Returns whether messages of level l are logged.
+   */
+  inline static bool enabled (LogLevel l) {
+    return l <= level_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the least important level logged.
+   */
+  inline static LogLevel level () {
+    return LogLevel(level_.load(std::memory_order_relaxed));
+  }
+
+  /**
+   * Sets the least important level logged (LogInfo by default).
+   */
+  inline static void set_level (LogLevel l) {
+    level_ = l;
+  }
+
+  /**
+   * Returns the level with the given name (error, warning, info
+   * or debug), or LogLevelSize if there is none.
+   */
+  static LogLevel parse (const std::string& name);
+
+  /**
+   * Returns the name of level l.
+   */
+  static const char* name (LogLevel l);
+
+  /**
+   * Writes everything logged so far, and returns once it is written.
+   */
+  static void flush ();
+
+};
+
+
+#endif
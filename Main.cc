@@ -7,6 +7,21 @@ void help (int argc, char** argv) {
   cout << "--seed=seed     -s seed     set random seed"                   << endl;
   cout << "--input=file    -i input    set input file  (default: stdin)"  << endl;
   cout << "--output=file   -o output   set output file (default: stdout)" << endl;
+  cout << "--decided       -d          stop when the winner cannot change" << endl;
+  cout << "--rng=kind      -r kind     random generator: legacy (default) or counter" << endl;
+  cout << "--cpu=seconds   -t seconds  cpu time of each player for the game" << endl;
+  cout << "--cpu-round=s   -T seconds  cpu time of each player for a round" << endl;
+  cout << "--cpu-init=s    -I seconds  cpu time of each player for init()" << endl;
+  cout << "--ponder        -n          let players ponder between their turns" << endl;
+  cout << "--threads=n     -j n        worker threads of each player (default: 0)" << endl;
+  cout << "--headless      -H          no replay" << endl;
+  cout << "--json=file     -J file     append the results to file as a JSON line" << endl;
+  cout << "--csv=file      -C file     append the results to file as CSV" << endl;
+  cout << "--log=level     -V level    log error, warning, info (default) or debug" << endl;
+  cout << "--parallel-init -p          run init() of all players in parallel" << endl;
+  cout << "--load=dir      -L dir      load the players in dir/AI*.so"  << endl;
+  cout << "--games=n       -g n        play n games, with seeds seed, seed+1..." << endl;
+  cout << "                            reloading changed players between them" << endl;
   cout << "--list          -l          list registered players"           << endl;
   cout << "--version       -v          print version"                     << endl;
   cout << "--help          -h          print help"                        << endl;
@@ -23,6 +38,20 @@ int main (int argc, char** argv) {
     { "seed",    required_argument, 0, 's' },
     { "input",   required_argument, 0, 'i' },
     { "output",  required_argument, 0, 'o' },
+    { "decided", no_argument,       0, 'd' },
+    { "rng",     required_argument, 0, 'r' },
+    { "cpu",     required_argument, 0, 't' },
+    { "cpu-round", required_argument, 0, 'T' },
+    { "cpu-init", required_argument, 0, 'I' },
+    { "ponder",  no_argument,       0, 'n' },
+    { "threads", required_argument, 0, 'j' },
+    { "headless", no_argument,      0, 'H' },
+    { "json",    required_argument, 0, 'J' },
+    { "csv",     required_argument, 0, 'C' },
+    { "log",     required_argument, 0, 'V' },
+    { "parallel-init", no_argument, 0, 'p' },
+    { "load",    required_argument, 0, 'L' },
+    { "games",   required_argument, 0, 'g' },
     { "list",    no_argument,       0, 'l' },
     { "version", no_argument,       0, 'v' },
     { "help",    no_argument,       0, 'h' },
@@ -32,11 +61,14 @@ int main (int argc, char** argv) {
   char* ifile = 0;
   char* ofile = 0;
   int seed = -1;
+  string json, csv;
+  int games = 1;
   vector<string> names;
+  Game_options opt;
 
   while (true) {
     int index = 0;
-    int c = getopt_long(argc, argv, "s:i:o:lvh", long_options, &index);
+    int c = getopt_long(argc, argv, "s:i:o:dr:t:T:I:nj:HJ:C:V:pL:g:lvh", long_options, &index);
     if (c == -1) break;
 
     switch (c) {
@@ -49,6 +81,54 @@ int main (int argc, char** argv) {
       case 'o':
         ofile = optarg;
         break;
+      case 'd':
+        opt.stop_when_decided = true;
+        break;
+      case 'r':
+        if (string(optarg) == "legacy") opt.rng = LegacyRng;
+        else if (string(optarg) == "counter") opt.rng = CounterRng;
+        else _my_assert(false, "Unknown random generator " + string(optarg) + ".");
+        break;
+      case 't':
+        opt.cpu_total = atof(optarg);
+        break;
+      case 'T':
+        opt.cpu_round = atof(optarg);
+        break;
+      case 'I':
+        opt.cpu_init = atof(optarg);
+        break;
+      case 'n':
+        opt.ponder = true;
+        break;
+      case 'j':
+        opt.threads = string_to_int(optarg);
+        _my_assert(opt.threads >= 0, "Wrong number of threads.");
+        break;
+      case 'H':
+        opt.headless = true;
+        break;
+      case 'J':
+        json = optarg;
+        break;
+      case 'C':
+        csv = optarg;
+        break;
+      case 'V':
+        _my_assert(Log::parse(optarg) != LogLevelSize,
+                   "Unknown log level " + string(optarg) + ".");
+        Log::set_level(Log::parse(optarg));
+        break;
+      case 'p':
+        opt.parallel_init = true;
+        break;
+      case 'L':
+        Registry::load(optarg);
+        break;
+      case 'g':
+        games = string_to_int(optarg);
+        _my_assert(games >= 1, "Wrong number of games.");
+        break;
       case 'l':
         Registry::print_players(cout);
         return EXIT_SUCCESS;
@@ -71,11 +151,23 @@ int main (int argc, char** argv) {
 
   _my_assert(seed >= 0, "Missing seed?");
 
-  istream* is = ifile ? new ifstream(ifile) : &cin;
-  ostream* os = ofile ? new ofstream(ofile) : &cout;
+  _my_assert(games == 1 or ifile, "Several games need an input file.");
 
-  Game::run(names, *is, *os, seed);
+  for (int g = 0; g < games; ++g) {
+    // players built again meanwhile are used from the next game on
+    if (g > 0) Registry::reload();
 
-  if (ifile) delete is;
-  if (ofile) delete os;
+    // with several games, each one goes to its own file output.seed
+    string oname = ofile ? string(ofile) : "";
+    if (ofile and games > 1) oname += "." + int_to_string(seed + g);
+
+    istream* is = ifile ? new ifstream(ifile) : &cin;
+    bool replay = ofile and not opt.headless;
+    ostream* os = replay ? new ofstream(oname.c_str()) : &cout;
+
+    Game::run(names, *is, *os, seed + g, opt).save(json, csv);
+
+    if (ifile) delete is;
+    if (replay) delete os;
+  }
 }
@@ -0,0 +1,103 @@
+#include "Planes.hh"
+
+
+/**
+ * Sixteen bytes, operated on at once by the compiler.
+ */
+typedef uint8_t Bytes __attribute__((vector_size(16)));
+
+
+/**
+ * Writes to out, for each of the n bytes of row, 1 if it is v and 0
+ * otherwise.
+ */
+static inline void match (const uint8_t* row, int n, uint8_t v, uint8_t* out) {
+  int j = 0;
+  for (; j + 16 <= n; j += 16) {
+    Bytes x;
+    memcpy(&x, row + j, 16);
+    Bytes m = (Bytes)(x == v) & 1;
+    memcpy(out + j, &m, 16);
+  }
+  for (; j < n; ++j) out[j] = row[j] == v;
+}
+
+
+/**
+ * Alias, with float values.
+ */
+static inline void match (const uint8_t* row, int n, uint8_t v, float* out) {
+  int j = 0;
+  for (; j + 16 <= n; j += 16) {
+    Bytes x;
+    memcpy(&x, row + j, 16);
+    Bytes m = (Bytes)(x == v) & 1;
+    for (int k = 0; k < 16; ++k) out[j + k] = m[k];
+  }
+  for (; j < n; ++j) out[j] = row[j] == v;
+}
+
+
+/**
+ * Stores v/m in x, as a float or as a byte where 255 is 1.
+ */
+static inline void scaled (float& x, int v, int m) {
+  x = float(v)/m;
+}
+
+static inline void scaled (uint8_t& x, int v, int m) {
+  x = (v*255 + m/2)/m;
+}
+
+
+Plane_encoder::Plane_encoder (const Settings& s)
+  : np_(s.nb_players()), rows_(s.rows()), cols_(s.cols()),
+    health_(s.warriors_health()), fuel_(s.cars_fuel()),
+    type_(cols_), owner_(cols_) { }
+
+
+template <typename T>
+void Plane_encoder::encode_ (const State& s, int pov, T* out) const {
+  _my_assert(pov >= 0 and pov < np_, "Wrong point of view.");
+  int n = rows_*cols_;
+
+  // every row is first reduced to the bytes that are compared
+  vector<uint8_t>& type = type_;
+  vector<uint8_t>& owner = owner_;
+  for (int i = 0; i < rows_; ++i) {
+    const Cell* c = s.grid_[i].data();
+    for (int j = 0; j < cols_; ++j) {
+      type[j] = c[j].type;
+      owner[j] = c[j].owner < 0 ? 0 : 1 + (c[j].owner - pov + np_)%np_;
+    }
+    T* o = out + i*cols_;
+    for (int t = 0; t < CellTypeSize; ++t)
+      match(type.data(), cols_, t, o + t*n);
+    for (int r = 0; r < np_; ++r)
+      match(owner.data(), cols_, r + 1, o + (CellTypeSize + r)*n);
+  }
+
+  fill(out + (CellTypeSize + np_)*n, out + size(), T(0));
+  for (const Unit& u : s.unit_) {
+    int k = u.pos.i*cols_ + u.pos.j;
+    if (u.type == Warrior) {
+      out[warrior_plane(u.player, pov)*n + k] = 1;
+      scaled(out[food_plane()*n + k], u.food, health_);
+      scaled(out[water_plane()*n + k], u.water, health_);
+    }
+    else {
+      out[car_plane(u.player, pov)*n + k] = 1;
+      scaled(out[fuel_plane()*n + k], u.food, fuel_);
+    }
+  }
+}
+
+
+void Plane_encoder::encode (const State& s, int pov, uint8_t* out) const {
+  encode_(s, pov, out);
+}
+
+
+void Plane_encoder::encode (const State& s, int pov, float* out) const {
+  encode_(s, pov, out);
+}
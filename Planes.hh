@@ -0,0 +1,126 @@
+#ifndef Planes_hh
+#define Planes_hh
+
+
+#include "Settings.hh"
+#include "State.hh"
+#include <cstdint>
+
+
+/** \file
+ * Contains the Plane_encoder class, which writes a state as a stack of
+ * dense planes, as used by learning pipelines.
+ */
+
+
+/**
+ * Encodes states as planes of rows() x cols() values, row by row, one
+ * plane after the other, in a buffer given by the caller:
+ *
+ * - one plane for each CellType, 1 where the cell is of that type;
+ * - one plane for each player, 1 where it owns the city cell;
+ * - one plane for each player, 1 where it has a warrior;
+ * - one plane for each player, 1 where it has a car;
+ * - the food and the water of the warriors, and the fuel of the cars,
+ *   divided by their maximum (0 where there is no such unit).
+ *
+ * Players are seen from the point of view of one of them: the planes of
+ * player pl are those of (pl - pov) mod nb_players(), so that pov always
+ * comes first. Values are floats, or bytes where 1 is 255 (for food,
+ * water and fuel) or 1 (for the rest).
+ *
+ * The planes of cells are built comparing 16 cells at a time, with the
+ * vector extensions of the compiler; those of units are written unit by
+ * unit on zeroed planes.
+ */
+class Plane_encoder {
+
+  int np_, rows_, cols_, health_, fuel_;
+
+  /**
+   * Scratch rows of encode_, so that encoding allocates nothing. An
+   * encoder thus encodes one state at a time.
+   */
+  mutable vector<uint8_t> type_, owner_;
+
+  /**
+   * Writes the planes of cells and units. T is uint8_t or float.
+   */
+  template <typename T>
+  void encode_ (const State& s, int pov, T* out) const;
+
+public:
+
+  /**
+   * Creates an encoder for states with the given settings.
+   */
+  explicit Plane_encoder (const Settings& s);
+
+  /**
+   * Returns the number of planes.
+   */
+  inline int nb_planes () const {
+    return CellTypeSize + 3*np_ + 3;
+  }
+
+  /**
+   * Returns the number of values of an encoded state.
+   */
+  inline int size () const {
+    return nb_planes()*rows_*cols_;
+  }
+
+  /**
+   * Returns the index of the plane of cells of type t.
+   */
+  inline int type_plane (CellType t) const {
+    return t;
+  }
+
+  /**
+   * Returns the index of the plane of the cities of player pl, seen
+   * from player pov. Likewise for warriors and cars.
+   */
+  inline int owner_plane (int pl, int pov) const {
+    return CellTypeSize + (pl - pov + np_)%np_;
+  }
+
+  inline int warrior_plane (int pl, int pov) const {
+    return CellTypeSize + np_ + (pl - pov + np_)%np_;
+  }
+
+  inline int car_plane (int pl, int pov) const {
+    return CellTypeSize + 2*np_ + (pl - pov + np_)%np_;
+  }
+
+  /**
+   * Returns the index of the planes of food, water and fuel.
+   */
+  inline int food_plane () const {
+    return CellTypeSize + 3*np_;
+  }
+
+  inline int water_plane () const {
+    return CellTypeSize + 3*np_ + 1;
+  }
+
+  inline int fuel_plane () const {
+    return CellTypeSize + 3*np_ + 2;
+  }
+
+  /**
+   * Writes the planes of s, seen from player pov, to out,
+   * which must have room for size() values. Not to be called from
+   * several threads at once on the same encoder.
+   */
+  void encode (const State& s, int pov, uint8_t* out) const;
+
+  /**
+   * Alias, with float values.
+   */
+  void encode (const State& s, int pov, float* out) const;
+
+};
+
+
+#endif
@@ -1,5 +1,66 @@
 #include "Player.hh"
 
+#include <mutex>
+
+
+static map<const Player*, Player_context> contexts_;
+static mutex contexts_mutex_;
+static atomic<unsigned> released_(0);  // Contexts released so far.
+
+
+// The context that each thread looked up last, valid while no context
+// has been released since: the accessors that players call in their hot
+// loops find it without the lock, in whichever thread they run.
+struct Last_context {
+  const Player* player;
+  Player_context* ctx;
+  unsigned released;
+};
+
+static thread_local Last_context last_ = { 0, 0, 0 };
+
+
+Player_context& Player::context () const {
+  unsigned r = released_.load(memory_order_acquire);
+  if (last_.player == this and last_.released == r) return *last_.ctx;
+  lock_guard<mutex> lock(contexts_mutex_);
+  Player_context& ctx = contexts_[this];
+  last_ = { this, &ctx, r };
+  return ctx;
+}
+
+
+void Player::release_context () const {
+  lock_guard<mutex> lock(contexts_mutex_);
+  contexts_.erase(this);
+  ++released_;
+}
+
+
+bool Player::commit () {
+  Player_context& ctx = context();
+  if (ctx.deadline.expired()) return false;
+  ctx.committed = v_.size();
+  return true;
+}
+
+
+void Player::reset (const Info& info, const Changes& ch) {
+  Action::clear();
+
+  if (ch.all() or grid_.size() != info.grid_.size()) grid_ = info.grid_;
+  else for (Pos p : ch.cells()) grid_[p.i][p.j] = info.grid_[p.i][p.j];
+
+  // the rest is small, and assigning reuses the memory of the previous round
+  round_ = info.round_;
+  unit_ = info.unit_;
+  num_cities_ = info.num_cities_;
+  total_score_ = info.total_score_;
+  cpu_status_ = info.cpu_status_;
+  warriors_ = info.warriors_;
+  cars_ = info.cars_;
+}
+
 
 void Player::reset (ifstream& is) {
   *(Action*)this = Action();
@@ -6,6 +6,38 @@
 #include "Action.hh"
 #include "Random.hh"
 #include "Registry.hh"
+#include "Event.hh"
+#include "Cache.hh"
+#include "Index.hh"
+#include "Combat.hh"
+#include "Deadline.hh"
+#include "Pool.hh"
+#include <atomic>
+
+
+/**
+ * Data that the game keeps for each player between rounds.
+ * It is stored outside Player because the layout of Player
+ * is fixed by the precompiled AIDummy objects.
+ */
+struct Player_context {
+
+  Changes changes;           // What changed since the previous call to play().
+  long long seq;             // First event not yet delivered to the player.
+  const Query_cache* cache;  // Queries about the current round, or null.
+  const Unit_index* index;   // Spatial index of the units, or null.
+  const Combat* combat;      // Combat oracle for this game, or null.
+  Deadline deadline;         // Cpu time budget of the current round.
+  int committed;             // Movements committed before the deadline, or -1.
+  atomic<bool> stop;         // Whether ponder() must return.
+  Worker_pool* pool;         // Worker threads of the player, or null.
+  uint64_t task_key;         // Key of the random streams of the tasks.
+
+  Player_context ()
+    : seq(0), cache(0), index(0), combat(0), committed(-1), stop(false),
+      pool(0), task_key(0) { }
+
+};
 
 
 /***
@@ -16,6 +48,25 @@
  *
  * In order to create new players, inherit from this class and register them.
  * See for example Null.cc and Demo.cc.
+ *
+ * Players may also define a method void init (), which the game calls
+ * once before round 0, with its own cpu budget, for precomputations.
+ * It is found when the player is registered, so it is not virtual.
+ *
+ * Likewise, players may define a method void ponder (). If the game
+ * allows it, ponder() runs in a background thread after every call to
+ * play(), until should_stop_pondering() tells it to return, just before
+ * the next call to play(). It may only read the state of the player as
+ * it was in play() and update data of its own: it must not command
+ * units, and queries() and unit_index() are not available. Its cpu
+ * time counts towards the budget of the game, and deadline() tells how
+ * much is left.
+ *
+ * Players may split their work into tasks for workers(), a pool of
+ * threads that the game keeps for each of them. The cpu time of the
+ * workers counts as cpu time of the player. Tasks that draw random
+ * numbers only from task_rng() give the same results however they are
+ * scheduled.
  */
 class Player : public Info, public Random_generator, public Action {
 
@@ -24,13 +75,26 @@ class Player : public Info, public Random_generator, public Action {
 
   int me_;
 
-  inline void reset (const Info& info) {
-    *static_cast<Action*>(this) = Action();
-    *static_cast<State*>(this) = (State)info;
-  }
+  /**
+   * Brings the state of the player up to date with info. Only the cells
+   * listed in ch are copied, since the others did not change since the
+   * previous reset, unless ch tells that everything changed.
+   */
+  void reset (const Info& info, const Changes& ch);
 
   void reset (ifstream& is);
 
+  /**
+   * Returns the context that the game keeps for this player. Only the
+   * first call of each thread for a player takes a lock.
+   */
+  Player_context& context () const;
+
+  /**
+   * Frees the context of this player.
+   */
+  void release_context () const;
+
 public:
 
   /**
@@ -46,6 +110,83 @@ public:
     return me_;
   }
 
+  /**
+   * Returns what changed on the board since the previous round,
+   * so that derived data can be updated incrementally.
+   */
+  inline const Changes& changes () const {
+    return context().changes;
+  }
+
+  /**
+   * Returns the queries about the current round, already computed by the
+   * game and shared with all the players.
+   */
+  inline const Query_cache& queries () const {
+    const Query_cache* c = context().cache;
+    _my_assert(c, "Queries requested outside of play().");
+    return *c;
+  }
+
+  /**
+   * Returns the spatial index of the units on the board.
+   */
+  inline const Unit_index& unit_index () const {
+    const Unit_index* x = context().index;
+    _my_assert(x, "Unit index requested outside of play().");
+    return *x;
+  }
+
+  /**
+   * Returns the combat oracle for the settings of this game.
+   */
+  inline const Combat& combat () const {
+    const Combat* c = context().combat;
+    _my_assert(c, "Combat oracle requested outside of play().");
+    return *c;
+  }
+
+  /**
+   * Returns the cpu time budget of the current round.
+   */
+  inline const Deadline& deadline () const {
+    return context().deadline;
+  }
+
+  /**
+   * Returns whether ponder() must return now.
+   */
+  inline bool should_stop_pondering () const {
+    return context().stop.load(memory_order_relaxed);
+  }
+
+  /**
+   * Commits the movements commanded so far. If play() goes over the
+   * budget of the round, the committed movements are still performed
+   * and the player is not disqualified; players that did not commit
+   * anything are. Commits made after the deadline are ignored;
+   * returns whether this one was accepted.
+   */
+  bool commit ();
+
+  /**
+   * Returns the worker threads of this player. Without threads (the
+   * default of the game), tasks run in the calling thread.
+   */
+  inline Worker_pool& workers () const {
+    Worker_pool* w = context().pool;
+    _my_assert(w, "Worker pool requested outside of the game.");
+    return *w;
+  }
+
+  /**
+   * Returns the random stream of task i of the current round, which
+   * depends only on the seed of the player, the round and i.
+   */
+  inline Counter_rng task_rng (int i) const {
+    return Counter_rng(Counter_rng::derive(context().task_key, round(), i));
+  }
+
 };
 
 
@@ -0,0 +1,161 @@
+#include "Pool.hh"
+#include <pthread.h>
+
+
+Worker_pool::Worker_pool (int nb_threads)
+  : pending_(0), active_(0), quit_(false), next_(0), cpu_ns_(0) {
+  for (int w = 0; w < nb_threads; ++w) queues_.emplace_back(new Queue());
+  for (int w = 0; w < nb_threads; ++w)
+    threads_.push_back(thread(&Worker_pool::work, this, w));
+}
+
+
+Worker_pool::~Worker_pool () {
+  {
+    lock_guard<mutex> l(m_);
+    quit_ = true;
+  }
+  cv_.notify_all();
+  for (thread& t : threads_) t.join();
+}
+
+
+void Worker_pool::work (int w) {
+  Queue& mine = *queues_[w];
+  if (pthread_getcpuclockid(pthread_self(), &mine.clock) != 0)
+    mine.clock = CLOCK_THREAD_CPUTIME_ID;
+  while (true) {
+    Task t;
+    if (pop(w, t)) {
+      run(w, t);
+      continue;
+    }
+    unique_lock<mutex> l(m_);
+    cv_.wait(l, [this] { return quit_ or pending_ > 0; });
+    if (quit_ and pending_ == 0) return;
+  }
+}
+
+
+bool Worker_pool::pop (int w, Task& t) {
+  int n = queues_.size();
+  for (int k = 0; k < n; ++k) {
+    Queue& q = *queues_[(w + k)%n];
+    lock_guard<mutex> l(q.m);
+    if (q.q.empty()) continue;
+    if (k == 0) {
+      t = move(q.q.back());
+      q.q.pop_back();
+    }
+    else {
+      t = move(q.q.front());
+      q.q.pop_front();
+    }
+    --pending_;
+    return true;
+  }
+  return false;
+}
+
+
+void Worker_pool::push (function<void()> f) {
+  Queue& q = *queues_[next_++%queues_.size()];
+  ++active_;
+  {
+    lock_guard<mutex> l(q.m);
+    q.q.push_back(Task{ move(f), Warnings::context() });
+  }
+  ++pending_;
+  {
+    lock_guard<mutex> l(m_);
+  }
+  cv_.notify_one();
+}
+
+
+void Worker_pool::run (int w, Task& t) {
+  Queue& mine = *queues_[w];
+  double start = thread_cpu_time();
+  mine.busy_since.store(start, memory_order_release);
+  {
+    Warnings::Scope s(t.w);
+    t.f();
+  }
+  // counted twice for a moment rather than not at all
+  cpu_ns_ += (long long)(1e9*(thread_cpu_time() - start));
+  mine.busy_since.store(-1, memory_order_release);
+  finished();
+}
+
+
+void Worker_pool::run_here (Task& t) {
+  {
+    Warnings::Scope w(t.w);
+    t.f();
+  }
+  finished();
+}
+
+
+void Worker_pool::finished () {
+  if (--active_ > 0) return;
+  {
+    lock_guard<mutex> l(m_);
+  }
+  idle_.notify_all();
+}
+
+
+void Worker_pool::parallel_for (int n, const function<void(int)>& body) {
+  if (threads_.empty() or n <= 1) {
+    for (int i = 0; i < n; ++i) body(i);
+    return;
+  }
+
+  // indices are handed out one by one, to whoever is free
+  shared_ptr< atomic<int> > next = make_shared< atomic<int> >(0);
+  shared_ptr< atomic<int> > helpers = make_shared< atomic<int> >(0);
+  int h = min(size(), n - 1);
+  *helpers = h;
+  for (int k = 0; k < h; ++k)
+    push([next, helpers, n, &body] {
+      for (int i; (i = (*next)++) < n; ) body(i);
+      --*helpers;
+    });
+
+  for (int i; (i = (*next)++) < n; ) body(i);
+
+  // helpers still queued are run here (they find nothing left to do)
+  while (*helpers > 0) {
+    Task t;
+    if (pop(0, t)) run_here(t);
+    else this_thread::yield();
+  }
+}
+
+
+void Worker_pool::wait_idle () {
+  // tasks still queued run here, charged to the thread that waits
+  Task t;
+  while (pop(0, t)) run_here(t);
+  unique_lock<mutex> l(m_);
+  idle_.wait(l, [this] { return active_ == 0; });
+}
+
+
+double Worker_pool::cpu_so_far () const {
+  double s = 1e-9*cpu_ns_.load();
+  for (const unique_ptr<Queue>& q : queues_) {
+    double since = q->busy_since.load(memory_order_acquire);
+    if (since < 0) continue;
+    timespec t;
+    if (clock_gettime(q->clock, &t) == 0)
+      s += max(0.0, t.tv_sec + 1e-9*t.tv_nsec - since);
+  }
+  return s;
+}
+
+
+double Worker_pool::take_cpu () {
+  return 1e-9*cpu_ns_.exchange(0);
+}
@@ -0,0 +1,161 @@
+#ifndef Pool_hh
+#define Pool_hh
+
+
+#include "Utils.hh"
+#include "Warning.hh"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+/** \file
+ * Contains the Worker_pool class, the threads that a player can use
+ * to parallelize its own work.
+ */
+
+
+/**
+ * A fixed set of worker threads with a task queue each. A task is
+ * pushed to one of the queues; idle workers take tasks from the back of
+ * their own queue, or steal them from the front of the others.
+ *
+ * The cpu time spent by the workers in tasks is accumulated, so that
+ * the game can charge it to the player, and the warnings of a task go
+ * where those of the thread that queued it do. A pool without threads
+ * runs every task in the calling thread.
+ *
+ * The game waits for the pool to be idle once play(), init() or ponder()
+ * returns, so tasks may outlive the call that submits them, but not the
+ * turn: their cpu time is charged to that turn.
+ *
+ * Tasks run in any order and in any thread: to be deterministic, they
+ * must not share mutable data, and must take their random numbers from
+ * streams that depend only on the task (see Player::task_rng()).
+ * Player::deadline() measures the thread that calls it, so it is only
+ * meaningful in the thread of play().
+ */
+class Worker_pool {
+
+  struct Task {
+    function<void()> f;
+    Warnings::Context w;  // Of the thread that queued it.
+  };
+
+  struct Queue {
+    mutex m;
+    deque<Task> q;
+    clockid_t clock;            // Cpu clock of its worker.
+    atomic<double> busy_since;  // Cpu time of the worker when its task began, or -1.
+
+    Queue () : busy_since(-1) { }
+  };
+
+  vector<thread> threads_;
+  vector< unique_ptr<Queue> > queues_;
+  mutex m_;
+  condition_variable cv_;
+  condition_variable idle_;
+  atomic<int> pending_;  // Tasks queued.
+  atomic<int> active_;   // Tasks queued or running.
+  atomic<bool> quit_;
+  atomic<unsigned> next_;
+  atomic<long long> cpu_ns_;
+
+  /**
+   * Main loop of worker w.
+   */
+  void work (int w);
+
+  /**
+   * Takes a task, preferably from queue w. Returns false if there is none.
+   */
+  bool pop (int w, Task& t);
+
+  /**
+   * Queues a task.
+   */
+  void push (function<void()> f);
+
+  /**
+   * Runs a task in worker w, adding its cpu time to the total.
+   */
+  void run (int w, Task& t);
+
+  /**
+   * Runs a task in the thread that waits for it, which is charged.
+   */
+  void run_here (Task& t);
+
+  /**
+   * Counts a task as finished, waking wait_idle() after the last one.
+   */
+  void finished ();
+
+public:
+
+  /**
+   * Creates a pool with the given number of threads (maybe 0).
+   */
+  explicit Worker_pool (int nb_threads);
+
+  /**
+   * Waits for the queued tasks and stops the threads.
+   */
+  ~Worker_pool ();
+
+  /**
+   * Returns the number of worker threads.
+   */
+  inline int size () const {
+    return threads_.size();
+  }
+
+  /**
+   * Runs f() in some worker and returns its future result.
+   * Do not wait for a future from inside another task.
+   */
+  template <typename F>
+  auto submit (F f) -> future<decltype(f())> {
+    typedef decltype(f()) R;
+    shared_ptr< packaged_task<R()> > t = make_shared< packaged_task<R()> >(f);
+    future<R> r = t->get_future();
+    if (threads_.empty()) (*t)();
+    else push([t] { (*t)(); });
+    return r;
+  }
+
+  /**
+   * Calls body(i) for all i in [0, n), in parallel, and returns when
+   * all calls have finished. The calling thread takes part too.
+   */
+  void parallel_for (int n, const function<void(int)>& body);
+
+  /**
+   * Returns when no task is queued or running, running queued tasks in
+   * the calling thread meanwhile.
+   */
+  void wait_idle ();
+
+  /**
+   * Returns the cpu seconds spent by the workers in tasks since the
+   * previous call.
+   */
+  double take_cpu ();
+
+  /**
+   * Returns the cpu seconds spent by the workers in tasks since the last
+   * call to take_cpu(), without taking them. Unlike take_cpu(), the tasks
+   * still running count too, as far as they have got.
+   */
+  double cpu_so_far () const;
+
+};
+
+
+#endif
@@ -1 +1,25 @@
 #include "Random.hh"
+
+
+const int Random_generator::NB_DIR_ORDERS;
+
+
+const unsigned char* Random_generator::dir_orders () {
+  static const vector<unsigned char> orders = [] {
+    vector<unsigned char> v;
+    v.reserve(8*NB_DIR_ORDERS);
+    unsigned char d[8] = { 0, 1, 2, 3, 4, 5, 6, 7 }; // from Bottom to LB
+    do v.insert(v.end(), d, d + 8);
+    while (next_permutation(d, d + 8));
+    return v;
+  }();
+  return orders.data();
+}
+
+
+void Counter_rng::random_permutation (int* v, int n) {
+  if (n < 0) return; // wrong n
+
+  for (int i = 0; i < n; ++i) v[i] = i;
+  for (int i = n - 1; i > 0; --i) swap(v[i], v[random(0, i)]);
+}
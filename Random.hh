@@ -3,6 +3,7 @@
 
 
 #include "Utils.hh"
+#include <cstdint>
 
 
 /**
@@ -69,6 +70,169 @@ public:
     return v;
   }
 
+  /**
+   * Stores in v[0..n-1] a random permutation of [0..n-1], drawing the same
+   * numbers as random_permutation(n). v must have room for n elements.
+   */
+  inline void random_permutation (int* v, int n) {
+    if (n < 0 or n > 1e6) return; // wrong n
+
+    for (int i = 0; i < n; ++i) v[i] = i;
+    for (int i = 0; i < n; ++i) swap(v[i], v[random(i, n  - 1)]);
+  }
+
+  /**
+   * Alias, that resizes v (only allocating if it has not enough capacity).
+   */
+  inline void random_permutation (vector<int>& v, int n) {
+    if (n < 0 or n > 1e6) n = 0; // wrong n
+
+    v.resize(n);
+    random_permutation(v.data(), n);
+  }
+
+  /**
+   * Number of orders of the eight directions other than None.
+   */
+  static const int NB_DIR_ORDERS = 40320;
+
+  /**
+   * Returns all the orders of the eight directions other than None,
+   * eight values per order.
+   */
+  static const unsigned char* dir_orders ();
+
+  /**
+   * Returns a random order of the eight directions other than None,
+   * drawing a single random number. It does not allocate memory.
+   */
+  inline View<unsigned char> random_dirs () {
+    const unsigned char* p = dir_orders() + 8*random(0, NB_DIR_ORDERS - 1);
+    return View<unsigned char>(p, p + 8);
+  }
+
+};
+
+
+/**
+ * Enum to encode the kinds of random generators of a board.
+ */
+enum RngKind {
+  LegacyRng,   // The generator of Random_generator, as in old replays.
+  CounterRng,  // Counter_rng, with a stream per subsystem.
+  RngKindSize
+};
+
+
+/**
+ * Enum to encode the independent random streams of a game.
+ */
+enum RngStream {
+  GeneratorStream,  // Random maps and initial units.
+  MovementStream,   // Order of movements and results of fights.
+  SpawningStream,   // Positions of respawned units.
+  PlayerStream,     // Seeds of the players.
+  RngStreamSize
+};
+
+
+/**
+ * Counter-based random generator: the k-th number of a stream is a
+ * hash of its key and k, so that streams derived from the same seed are
+ * independent and do not depend on how many numbers others have used.
+ * The hash is the finalizer of SplitMix64, applied twice.
+ */
+class Counter_rng {
+
+  uint64_t key_;
+  uint64_t ctr_;
+
+  inline static uint64_t mix (uint64_t x) {
+    x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+public:
+
+  /**
+   * Creates the stream with the given key.
+   */
+  explicit Counter_rng (uint64_t key = 0) : key_(key), ctr_(0) { }
+
+  /**
+   * Returns the key of the stream for the given seed and
+   * identifiers (a subsystem, a player, a round...).
+   */
+  inline static uint64_t derive (uint64_t seed, uint64_t a, uint64_t b = 0) {
+    return mix(mix(mix(seed) ^ (a + 0x9e3779b97f4a7c15ULL))
+               ^ (b + 0x632be59bd9b4e019ULL));
+  }
+
+  /**
+   * Restarts the stream with the given key.
+   */
+  inline void reseed (uint64_t key) {
+    key_ = key;
+    ctr_ = 0;
+  }
+
+  /**
+   * Returns the k-th 64-bit number of the stream.
+   */
+  inline uint64_t at (uint64_t k) const {
+    return mix(mix(key_ + k*0x9e3779b97f4a7c15ULL) ^ key_);
+  }
+
+  /**
+   * Returns the next 64-bit number of the stream.
+   */
+  inline uint64_t next () {
+    return at(ctr_++);
+  }
+
+  /**
+   * Returns a random integer in [l..u], without bias.
+   */
+  inline int random (int l, int u) {
+    if (l > u) return l; // wrong interval
+
+    // multiply and shift, rejecting the few values that would bias it
+    uint64_t m = uint64_t((long long)u - l) + 1;
+    uint64_t x = next() >> 32;
+    uint64_t r = x*m;
+    if ((r & 0xffffffffULL) < m) {
+      uint64_t t = ((1ULL << 32) - m)%m;
+      while ((r & 0xffffffffULL) < t) {
+        x = next() >> 32;
+        r = x*m;
+      }
+    }
+    return int((long long)l + (long long)(r >> 32));
+  }
+
+  /**
+   * Stores in v[0..n-1] a random permutation of [0..n-1].
+   */
+  void random_permutation (int* v, int n);
+
+  /**
+   * Alias, that resizes v (only allocating if it has not enough capacity).
+   */
+  inline void random_permutation (vector<int>& v, int n) {
+    v.resize(max(n, 0));
+    random_permutation(v.data(), n);
+  }
+
+  /**
+   * Returns a random permutation of [0..n-1].
+   */
+  inline vector<int> random_permutation (int n) {
+    vector<int> v;
+    random_permutation(v, n);
+    return v;
+  }
+
 };
 
 
@@ -1,19 +1,99 @@
 #include "Registry.hh"
+#include "Log.hh"
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
 
 
 typedef map<string, Registry::Factory> dict_;
 
 
 dict_* reg_ = 0;
+map<string, Registry::Initializer>* inits_ = 0;
+map<string, Registry::Ponderer>* ponders_ = 0;
+map<string, Registry::Deleter>* deleters_ = 0;
+
+
+/**
+ * A player linked into the executable, kept to register it again when a
+ * library that replaced it is closed.
+ */
+struct Linked {
+  Registry::Factory factory;
+  Registry::Initializer init;
+  Registry::Ponderer ponder;
+  Registry::Deleter del;
+};
+
+map<string, Linked>* linked_ = 0;
+
+
+/**
+ * A library of players opened with dlopen.
+ */
+struct Library {
+  void* handle;
+  long long mtime;       // Modification time of the file, in nanoseconds.
+  vector<string> names;  // Players that it registered.
+  vector<Registry::Factory> factories;  // Their factories.
+};
+
+map<string, Library>* libs_ = 0;  // By path.
+set<string>* dirs_ = 0;           // Directories given to load().
+Library* loading_ = 0;            // Library being opened, if any.
+
+
+/**
+ * Sets the function of name in m, or removes it if f is null.
+ */
+template <typename F>
+static void set_function (map<string, F>& m, const string& name, F f) {
+  if (f) m[name] = f;
+  else m.erase(name);  // a loaded player may replace one that had it
+}
 
 
 int Registry::Register (const char* name, Factory factory) {
+  return Register(name, factory, 0, 0, 0);
+}
+
+
+int Registry::Register (const char* name, Factory factory, Initializer init,
+                        Ponderer ponder) {
+  return Register(name, factory, init, ponder, 0);
+}
+
+
+int Registry::Register (const char* name, Factory factory, Initializer init,
+                        Ponderer ponder, Deleter del) {
   if (reg_ == 0) reg_ = new dict_();
+  if (inits_ == 0) inits_ = new map<string, Initializer>();
+  if (ponders_ == 0) ponders_ = new map<string, Ponderer>();
+  if (deleters_ == 0) deleters_ = new map<string, Deleter>();
+  if (linked_ == 0) linked_ = new map<string, Linked>();
+  if (loading_) {
+    if (reg_->count(name))
+      _info("player " << name << " replaced by a loaded one");
+    loading_->names.push_back(name);
+    loading_->factories.push_back(factory);
+  }
+  else (*linked_)[name] = Linked{factory, init, ponder, del};
   (*reg_)[name] = factory;
+  set_function(*inits_, name, init);
+  set_function(*ponders_, name, ponder);
+  set_function(*deleters_, name, del);
   return 999;
 }
 
 
+Registry::Initializer Registry::initializer (string name) {
+  if (inits_ == 0) return 0;
+  auto it = inits_->find(name);
+  return it == inits_->end() ? 0 : it->second;
+}
+
+
 Player* Registry::new_player (string name) {
   auto it = reg_->find(name);
   _my_assert(it != reg_->end(), "Player " + name + " not registered.");
@@ -21,6 +101,137 @@ Player* Registry::new_player (string name) {
 }
 
 
+
+void Registry::delete_player (string name, Player* p) {
+  if (deleters_ == 0) return;
+  auto it = deleters_->find(name);
+  if (it != deleters_->end()) (it->second)(p);
+}
+
+
+Registry::Ponderer Registry::ponderer (string name) {
+  if (ponders_ == 0) return 0;
+  auto it = ponders_->find(name);
+  return it == ponders_->end() ? 0 : it->second;
+}
+
 void Registry::print_players (ostream& os) {
   for (const auto& it : *reg_) cout << it.first << endl;
 }
+
+
+/**
+ * Returns the AI*.so files in dir, with their modification times.
+ */
+static map<string, long long> libraries_in (const string& dir) {
+  map<string, long long> libs;
+  DIR* d = opendir(dir.c_str());
+  if (d == 0) {
+    _warning("cannot open directory " << dir);
+    return libs;
+  }
+  while (dirent* e = readdir(d)) {
+    string f = e->d_name;
+    if (f.size() <= 5 or f.compare(0, 2, "AI") != 0
+        or f.compare(f.size() - 3, 3, ".so") != 0) continue;
+    string path = dir + "/" + f;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+      libs[path] = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+  }
+  closedir(d);
+  return libs;
+}
+
+
+/**
+ * Opens a library, which registers its players. Returns whether it could.
+ */
+static bool open_library (const string& path, long long mtime) {
+  Library lib;
+  lib.mtime = mtime;
+  loading_ = &lib;
+  lib.handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  loading_ = 0;
+  if (lib.handle == 0) {
+    _warning("cannot load " << path << ": " << dlerror());
+    return false;
+  }
+  if (lib.names.empty())
+    _warning("library " << path << " registers no player");
+  _info("loaded " << path);
+  if (libs_ == 0) libs_ = new map<string, Library>();
+  (*libs_)[path] = lib;
+  return true;
+}
+
+
+/**
+ * Unregisters the players of a library and closes it. The linked in
+ * players that it replaced are registered again.
+ */
+static void close_library (map<string, Library>::iterator it) {
+  const Library& lib = it->second;
+  for (int i = 0; i < (int)lib.names.size(); ++i) {
+    const string& name = lib.names[i];
+    auto r = reg_->find(name);
+    if (r == reg_->end() or r->second != lib.factories[i]) continue;
+    auto l = linked_->find(name);
+    if (l == linked_->end()) {
+      reg_->erase(r);
+      inits_->erase(name);
+      ponders_->erase(name);
+      deleters_->erase(name);
+    }
+    else {
+      _info("linked in player " << name << " registered again");
+      r->second = l->second.factory;
+      set_function(*inits_, name, l->second.init);
+      set_function(*ponders_, name, l->second.ponder);
+      set_function(*deleters_, name, l->second.del);
+    }
+  }
+  dlclose(lib.handle);
+  libs_->erase(it);
+}
+
+
+int Registry::load (string dir) {
+  if (dirs_ == 0) dirs_ = new set<string>();
+  dirs_->insert(dir);
+  int n = 0;
+  for (const auto& f : libraries_in(dir))
+    if (libs_ == 0 or libs_->count(f.first) == 0)
+      n += open_library(f.first, f.second);
+  return n;
+}
+
+
+int Registry::reload () {
+  if (dirs_ == 0) return 0;
+  map<string, long long> files;
+  for (const string& dir : *dirs_) {
+    map<string, long long> f = libraries_in(dir);
+    files.insert(f.begin(), f.end());
+  }
+
+  // libraries that changed or disappeared are closed first
+  if (libs_)
+    for (auto it = libs_->begin(); it != libs_->end(); ) {
+      auto f = files.find(it->first);
+      if (f != files.end() and f->second == it->second.mtime) ++it;
+      else close_library(it++);
+    }
+
+  int n = 0;
+  for (const auto& f : files)
+    if (libs_ == 0 or libs_->count(f.first) == 0)
+      n += open_library(f.first, f.second);
+  return n;
+}
+
+
+void Registry::unload () {
+  if (libs_ == 0) return;
+  while (not libs_->empty()) close_library(libs_->begin());
+}
@@ -3,6 +3,7 @@
 
 
 #include "Utils.hh"
+#include <utility>
 
 
 /** \file
@@ -16,6 +17,15 @@ class Player;
 /**
  * Since the main program does not know how many players will be inherited
  * from the Player class, we use a registration and factory pattern.
+ *
+ * Players are either linked into the executable, or built as shared
+ * objects AI*.so (see the Makefile) and loaded from a directory with
+ * load(). Loaded players register themselves when their library is
+ * opened, replacing any player with the same name until they are
+ * closed, and reload() opens again the libraries that changed since.
+ * No player of a library may be alive when it is reloaded, so this is
+ * done between games. To replace a library that is loaded, move the new
+ * one over it rather than writing into it.
  */
 class Registry {
 
@@ -23,18 +33,124 @@ public:
 
   typedef Player* (*Factory)();
 
+  /**
+   * Calls the init() method of a player, which is not virtual.
+   */
+  typedef void (*Initializer)(Player*);
+
   static int Register (const char* name, Factory fact);
 
+  /**
+   * Calls the ponder() method of a player, which is not virtual.
+   */
+  typedef void (*Ponderer)(Player*);
+
+  static int Register (const char* name, Factory fact, Initializer init,
+                       Ponderer ponder);
+
+  /**
+   * Deletes a player as its own class, since Player has no virtual
+   * destructor.
+   */
+  typedef void (*Deleter)(Player*);
+
+  static int Register (const char* name, Factory fact, Initializer init,
+                       Ponderer ponder, Deleter del);
+
   static Player* new_player (string name);
 
+  /**
+   * Deletes player p, made by new_player(name). Players registered
+   * without a deleter are linked in, and are left alive.
+   */
+  static void delete_player (string name, Player* p);
+
+  /**
+   * Returns the initializer of the player registered as name,
+   * or null if it has no init() method.
+   */
+  static Initializer initializer (string name);
+
+  /**
+   * Returns the ponderer of the player registered as name,
+   * or null if it has no ponder() method.
+   */
+  static Ponderer ponderer (string name);
+
   static void print_players (ostream& os);
 
+  /**
+   * Loads the players of all the AI*.so libraries in directory dir.
+   * Returns the number of libraries loaded.
+   */
+  static int load (string dir);
+
+  /**
+   * Loads again the libraries that changed since they were loaded, and
+   * those that appeared, in the directories given to load(). Returns the
+   * number of libraries loaded.
+   */
+  static int reload ();
+
+  /**
+   * Unloads all the libraries, and unregisters their players. Linked
+   * in players that a library replaced are registered again.
+   */
+  static void unload ();
+
+  /**
+   * Returns a function calling T::init(), if T has such a method.
+   */
+  template <typename T>
+  static auto initializer_of (int) -> decltype(declval<T&>().init(), Initializer()) {
+    return [](Player* p) { static_cast<T*>(p)->init(); };
+  }
+
+  /**
+   * Returns null, for players without an init() method.
+   */
+  template <typename T>
+  static Initializer initializer_of (...) {
+    return 0;
+  }
+
+  /**
+   * Returns a function calling T::ponder(), if T has such a method.
+   */
+  template <typename T>
+  static auto ponderer_of (int) -> decltype(declval<T&>().ponder(), Ponderer()) {
+    return [](Player* p) { static_cast<T*>(p)->ponder(); };
+  }
+
+  /**
+   * Returns null, for players without a ponder() method.
+   */
+  template <typename T>
+  static Ponderer ponderer_of (...) {
+    return 0;
+  }
+
+  /**
+   * Returns a function deleting a T. T is the exact class of the
+   * player, so its lack of a virtual destructor does not matter.
+   */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdelete-non-virtual-dtor"
+  template <typename T>
+  static Deleter deleter_of () {
+    return [](Player* p) { delete static_cast<T*>(p); };
+  }
+#pragma GCC diagnostic pop
+
 };
 
 
 #define _stringification(s) #s
 #define RegisterPlayer(x) static int registration = \
-        Registry::Register(_stringification(x), x::factory)
+        Registry::Register(_stringification(x), x::factory, \
+                           Registry::initializer_of<x>(0), \
+                           Registry::ponderer_of<x>(0), \
+                           Registry::deleter_of<x>())
 
 
 #endif
@@ -0,0 +1,449 @@
+#include "SecGame.hh"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <thread>
+
+
+SecGame::Layout SecGame::layout (const Settings& s) {
+  auto align = [](size_t x) { return (x + 63)/64*64; };
+  int np = s.nb_players();
+  int nu = np*(s.nb_warriors() + s.nb_cars());
+  Layout l;
+  l.grid = align(sizeof(Header));
+  l.units = align(l.grid + sizeof(Cell)*s.rows()*s.cols());
+  l.cities = align(l.units + sizeof(Unit)*nu);
+  l.scores = align(l.cities + sizeof(int)*np);
+  l.status = align(l.scores + sizeof(int)*np);
+  l.actions = align(l.status + sizeof(double)*np);
+  l.size = align(l.actions + sizeof(Movement)*Action::MAX_MOVEMENTS);
+  return l;
+}
+
+
+bool SecGame::wait_turn (int* word, int turn, double timeout, int pid) {
+  // the other side usually answers at once: spin a little before sleeping
+  for (int k = 0; k < 2000; ++k)
+    if (__atomic_load_n(word, __ATOMIC_ACQUIRE) != turn) return true;
+
+  timespec wall0;
+  clock_gettime(CLOCK_MONOTONIC, &wall0);
+  while (__atomic_load_n(word, __ATOMIC_ACQUIRE) == turn) {
+    // sleeps in slices, to notice when the process dies
+    timespec slice = { 0, 50000000 };
+    syscall(SYS_futex, word, FUTEX_WAIT, turn, pid > 0 ? &slice : 0, 0, 0);
+    if (pid > 0 and waitpid(pid, 0, WNOHANG) == pid) break;
+    if (timeout > 0) {
+      timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double elapsed = (now.tv_sec - wall0.tv_sec)
+        + 1e-9*(now.tv_nsec - wall0.tv_nsec);
+      if (elapsed > timeout) break;
+    }
+  }
+  return __atomic_load_n(word, __ATOMIC_ACQUIRE) != turn;
+}
+
+
+void SecGame::give_turn (int* word, int turn) {
+  __atomic_store_n(word, turn, __ATOMIC_RELEASE);
+  syscall(SYS_futex, word, FUTEX_WAKE, 1, 0, 0, 0);
+}
+
+
+SecGame::Process SecGame::launch (const Board& b, int pl, const string& name,
+                                  const Game_options& opt,
+                                  const SecGame_options& sec) {
+  Process p;
+  p.lay = layout(b);
+  p.idle = 0;
+
+  // the segment has no name: the player inherits the descriptor
+  string shm_name = "/secgame." + int_to_string(getpid()) + "." + int_to_string(pl);
+  p.fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  _my_assert(p.fd >= 0, "Cannot create shared memory for " + name + ".");
+  shm_unlink(shm_name.c_str());
+  _my_assert(ftruncate(p.fd, p.lay.size) == 0, "Cannot size shared memory.");
+  void* m = mmap(0, p.lay.size, PROT_READ | PROT_WRITE, MAP_SHARED, p.fd, 0);
+  _my_assert(m != MAP_FAILED, "Cannot map shared memory.");
+  p.shm = (char*)m;
+
+  // the player gives the turn back once it is ready
+  Header* h = (Header*)p.shm;
+  h->turn = PlayerTurn;
+  h->me = pl;
+  h->seed = b.player_seed(pl);
+  h->round = 0;
+  h->nb_actions = 0;
+  h->threads = opt.threads;
+  h->log_level = Log::level();
+  h->settings = b;
+
+  string exe = sec.exe_dir + "/AI" + name + ".exe";
+  string fd = int_to_string(p.fd);
+  Log::flush(); // or else the child could write its error before them
+  p.pid = fork();
+  _my_assert(p.pid >= 0, "Cannot fork for " + name + ".");
+  if (p.pid == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    fcntl(p.fd, F_SETFD, 0);
+    if (opt.cpu_total > 0) {
+      rlim_t s = rlim_t(ceil(opt.cpu_total)) + 1;
+      rlimit r = { s, s + 1 };
+      setrlimit(RLIMIT_CPU, &r);
+    }
+    if (sec.memory_mb > 0) {
+      rlim_t s = rlim_t(sec.memory_mb) << 20;
+      rlimit r = { s, s };
+      setrlimit(RLIMIT_AS, &r);
+    }
+    rlimit no_core = { 0, 0 };
+    setrlimit(RLIMIT_CORE, &no_core);
+    execl(exe.c_str(), exe.c_str(), "--player", name.c_str(),
+          "--fd", fd.c_str(), (char*)0);
+    // not logged: the log of this copy of the process has no flusher,
+    // and its lock may have been taken when it was copied
+    cerr << "ERROR: cannot execute " << exe << endl;
+    _exit(EXIT_FAILURE);
+  }
+
+  _my_assert(clock_getcpuclockid(p.pid, &p.clock) == 0,
+             "Cannot get the cpu clock of " + name + ".");
+  return p;
+}
+
+
+void SecGame::finish (Process& p, bool kill) {
+  if (p.pid > 0) {
+    if (kill) ::kill(p.pid, SIGKILL);
+    else give_turn(&((Header*)p.shm)->turn, QuitTurn);
+    waitpid(p.pid, 0, 0);
+    p.pid = -1;
+  }
+  if (p.shm) {
+    munmap(p.shm, p.lay.size);
+    close(p.fd);
+    p.shm = 0;
+  }
+}
+
+
+void SecGame::write_snapshot (const Board& b, Process& p,
+                              double cpu_round, double cpu_left) {
+  Header* h = (Header*)p.shm;
+  const Layout& l = p.lay;
+  Cell* grid = (Cell*)(p.shm + l.grid);
+  for (int i = 0; i < b.rows(); ++i)
+    copy(b.grid_[i].begin(), b.grid_[i].end(), grid + i*b.cols());
+  copy(b.unit_.begin(), b.unit_.end(), (Unit*)(p.shm + l.units));
+  copy(b.num_cities_.begin(), b.num_cities_.end(), (int*)(p.shm + l.cities));
+  copy(b.total_score_.begin(), b.total_score_.end(), (int*)(p.shm + l.scores));
+  copy(b.cpu_status_.begin(), b.cpu_status_.end(), (double*)(p.shm + l.status));
+  h->round = b.round();
+  h->nb_actions = 0;
+  h->committed = -1;
+  h->ponder = 0;
+  h->cpu_round = cpu_round;
+  h->cpu_left = cpu_left;
+}
+
+
+double SecGame::cpu_time (const Process& p) {
+  timespec t;
+  if (p.pid <= 0 or clock_gettime(p.clock, &t) != 0) return 0;
+  return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+
+void SecGame::initialize (Board& b, vector<Process>& procs,
+                          const Game_options& opt, const SecGame_options& sec) {
+  // all the players run init() at the same time, each in its process
+  int np = procs.size();
+  vector<double> start(np);
+  for (int pl = 0; pl < np; ++pl)
+    if (b.cpu_status_[pl] >= 0) {
+      write_snapshot(b, procs[pl], opt.cpu_init, 0);
+      start[pl] = cpu_time(procs[pl]);
+      give_turn(&((Header*)procs[pl].shm)->turn, InitTurn);
+    }
+
+  for (int pl = 0; pl < np; ++pl)
+    if (b.cpu_status_[pl] >= 0) {
+      Header* h = (Header*)procs[pl].shm;
+      bool ok = wait_turn(&h->turn, InitTurn, sec.timeout, procs[pl].pid)
+        and __atomic_load_n(&h->turn, __ATOMIC_ACQUIRE) == MasterTurn;
+      procs[pl].idle = cpu_time(procs[pl]);
+      double used = max(0.0, procs[pl].idle - start[pl]);
+      _info("player " << b.name(pl) << " initialized in " << used
+            << " seconds of cpu");
+      if (not ok or (opt.cpu_init > 0 and used > opt.cpu_init)) {
+        _info("player " << b.name(pl)
+              << " disqualified: init() failed or went over its budget");
+        b.cpu_status_[pl] = -1;
+        finish(procs[pl], true);
+      }
+    }
+}
+
+
+bool SecGame::play_round (const Board& b, Process& p, Action& act,
+                          double& used, double& pondered, int& committed,
+                          double cpu_left, const Game_options& opt,
+                          const SecGame_options& sec) {
+  act.clear();
+  used = pondered = 0;
+  committed = -1;
+  if (p.pid <= 0) return false;
+
+  Header* h = (Header*)p.shm;
+  const Layout& l = p.lay;
+  write_snapshot(b, p, opt.cpu_round, cpu_left);
+  h->ponder = opt.ponder;
+
+  // whatever the process did since it last answered is charged, whether
+  // it pondered or left threads of its own running
+  double t0 = cpu_time(p);
+  pondered = max(0.0, t0 - p.idle);
+  give_turn(&h->turn, PlayerTurn);
+  bool ok = wait_turn(&h->turn, PlayerTurn, sec.timeout, p.pid);
+  p.idle = cpu_time(p);
+  used = max(0.0, p.idle - t0);
+  if (not ok or __atomic_load_n(&h->turn, __ATOMIC_ACQUIRE) != MasterTurn)
+    return false;
+
+  // nothing written by the player is trusted
+  int n = h->nb_actions;
+  if (n < 0 or n > Action::MAX_MOVEMENTS) return false;
+  const Movement* v = (const Movement*)(p.shm + l.actions);
+  for (int k = 0; k < n; ++k) act.command(v[k]);
+  committed = max(-1, min(h->committed, n));
+  return true;
+}
+
+
+Game_result SecGame::run (vector<string> names, istream& is, ostream& os,
+                          int seed, const Game_options& opt,
+                          const SecGame_options& sec) {
+  double start = wall_time();
+  Game_result res;
+  res.seed = seed;
+  _info("seed " << seed);
+
+  _info("loading game");
+  Board b(is, seed, opt.rng);
+  _info("loaded game");
+
+  Warnings::Scope warnings(b.warnings_, -1);
+
+  int np = b.nb_players();
+  int nr = b.nb_rounds();
+
+  _my_assert(np == (int)names.size(), "Wrong number of players.");
+
+  signal(SIGPIPE, SIG_IGN);
+  vector<Process> procs;
+  for (int pl = 0; pl < np; ++pl) {
+    string name = names[pl];
+    b.names_[pl] = name;
+    _info("launching player " << name);
+    procs.push_back(launch(b, pl, name, opt, sec));
+  }
+  for (int pl = 0; pl < np; ++pl) {
+    Header* h = (Header*)procs[pl].shm;
+    if (not wait_turn(&h->turn, PlayerTurn, sec.timeout, procs[pl].pid)) {
+      _info("player " << b.name(pl) << " could not start");
+      b.cpu_status_[pl] = -1;
+      finish(procs[pl], true);
+    }
+  }
+  _info("players launched");
+  initialize(b, procs, opt, sec);
+
+  ostream null(0);
+  ostream& out = opt.headless ? null : os;
+  out << "Game" << endl << endl;
+  out << "Seed " << seed << endl << endl;
+  b.print_preamble(out);
+  b.print_names(out);
+  if (not opt.headless) b.print_state(out);
+
+  vector<Action> acts(np);
+  vector<const Action*> actions(np);
+  vector<double> cpu_used(np, 0);
+  for (int round = 0; round < nr; ++round) {
+    _debug("start round " << round);
+    for (int pl = 0; pl < np; ++pl) {
+      actions[pl] = &acts[pl];
+      if (b.cpu_status_[pl] < 0) {
+        acts[pl].clear();
+        continue;
+      }
+      _debug("    start player " << pl);
+      double used, pondered;
+      int committed;
+      double left = opt.cpu_total > 0 ? opt.cpu_total - cpu_used[pl] : 0;
+      Warnings::set_player(pl);
+      bool ok = play_round(b, procs[pl], acts[pl], used, pondered, committed,
+                           left, opt, sec);
+      Warnings::set_player(-1);
+      cpu_used[pl] += pondered + used;
+      if (not ok) {
+        _info("player " << b.name(pl) << " disqualified in round "
+              << round << ": it failed or did not answer");
+        b.cpu_status_[pl] = -1;
+      }
+      else if (not Game::account_cpu(b, pl, used, cpu_used[pl], acts[pl],
+                                     committed, opt))
+        ok = false;
+      if (not ok) {
+        acts[pl].clear();
+        finish(procs[pl], true);
+      }
+      _debug("    end player " << pl);
+    }
+
+    b.next(actions, out);
+    res.cities.push_back(b.num_cities_);
+    if (not opt.headless) b.print_state(out);
+    _debug("end round " << round);
+
+    vector<int> lower, upper;
+    if (opt.stop_when_decided and round + 1 < nr
+        and b.result_decided(lower, upper)) {
+      _info("result decided at round " << round);
+      b.decide(lower, upper);
+      break;
+    }
+  }
+
+  for (Process& p : procs) finish(p, false);
+
+  // the results come last but one, where scripts look for them
+  b.warnings_.print_summary(b.names_);
+  for (int pl = 0; pl < np; ++pl)
+    _info("player " << b.name(pl) << " used " << cpu_used[pl]
+          << " seconds of cpu");
+  b.print_results();
+
+  Game::finish(b, cpu_used, start, res);
+  _info("game played");
+  return res;
+}
+
+
+void SecGame::run_player (const string& name, int fd) {
+  Header* h = (Header*)mmap(0, sizeof(Header), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+  _my_assert(h != MAP_FAILED, "Cannot map shared memory.");
+  Layout l = layout(h->settings);
+  munmap(h, sizeof(Header));
+  char* shm = (char*)mmap(0, l.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  _my_assert(shm != MAP_FAILED, "Cannot map shared memory.");
+  h = (Header*)shm;
+
+  Log::set_level(LogLevel(h->log_level));
+  Player* p = Registry::new_player(name);
+  p->me_ = h->me;
+  Warnings::set_player(h->me);
+  p->set_random_seed(h->seed);
+  *static_cast<Settings*>(p) = h->settings;
+  int np = p->nb_players();
+  int nu = np*(p->nb_warriors() + p->nb_cars());
+  p->grid_ = vector< vector<Cell> >(p->rows(), vector<Cell>(p->cols()));
+  p->unit_ = vector<Unit>(nu);
+  p->num_cities_ = p->total_score_ = vector<int>(np);
+  p->cpu_status_ = vector<double>(np);
+
+  // the same helpers that Game gives to players, computed here
+  Query_cache cache(*p);
+  Combat combat(*p);
+  Unit_index index;
+  Worker_pool pool(h->threads);
+  Player_context& ctx = p->context();
+  ctx.cache = &cache;
+  ctx.index = &index;
+  ctx.combat = &combat;
+  ctx.pool = &pool;
+  ctx.task_key = Counter_rng::derive(h->seed, PlayerStream);
+
+  Registry::Initializer init = Registry::initializer(name);
+  Registry::Ponderer ponder = Registry::ponderer(name);
+  thread pondering;
+
+  give_turn(&h->turn, MasterTurn);
+  while (wait_turn(&h->turn, MasterTurn, 0, 0)) {
+    if (pondering.joinable()) {
+      ctx.stop = true;
+      pondering.join();
+    }
+    int turn = __atomic_load_n(&h->turn, __ATOMIC_ACQUIRE);
+    if (turn != PlayerTurn and turn != InitTurn) break;
+
+    p->Action::clear();
+    ctx.cache = &cache;
+    ctx.index = &index;
+    ctx.committed = -1;
+    ctx.deadline.start(h->cpu_round, h->cpu_left, &pool);
+    const Cell* grid = (const Cell*)(shm + l.grid);
+    for (int i = 0; i < p->rows(); ++i)
+      copy(grid + i*p->cols(), grid + (i + 1)*p->cols(), p->grid_[i].begin());
+    const Unit* units = (const Unit*)(shm + l.units);
+    copy(units, units + nu, p->unit_.begin());
+    const int* cities = (const int*)(shm + l.cities);
+    copy(cities, cities + np, p->num_cities_.begin());
+    const int* scores = (const int*)(shm + l.scores);
+    copy(scores, scores + np, p->total_score_.begin());
+    const double* status = (const double*)(shm + l.status);
+    copy(status, status + np, p->cpu_status_.begin());
+    p->round_ = h->round;
+    p->update_vectors_by_player();
+
+    // the cache is lazy: a player only pays for the queries it makes
+    index.reset(p->rows(), p->cols(), np);
+    for (const Unit& u : p->unit_) index.add(u.player, u.type, u.pos);
+
+    if (turn == InitTurn) {
+      if (init) init(p);
+      pool.wait_idle();
+      give_turn(&h->turn, MasterTurn);
+      continue;
+    }
+
+    p->play();
+    pool.wait_idle();
+
+    int n = min((int)p->v_.size(), (int)Action::MAX_MOVEMENTS);
+    copy(p->v_.begin(), p->v_.begin() + n, (Movement*)(shm + l.actions));
+    h->nb_actions = n;
+    h->committed = ctx.committed;
+    bool may_ponder = ponder and h->ponder;
+    double left = h->cpu_left;
+    give_turn(&h->turn, MasterTurn);
+
+    if (may_ponder) {
+      ctx.cache = 0;
+      ctx.index = 0;
+      ctx.stop = false;
+      pondering = thread([&, left] {
+        Warnings::set_player(p->me());
+        ctx.deadline.start(0, left, &pool);
+        ponder(p);
+        pool.wait_idle();
+      });
+    }
+  }
+
+  if (pondering.joinable()) {
+    ctx.stop = true;
+    pondering.join();
+  }
+
+  p->release_context();
+}
@@ -0,0 +1,169 @@
+#ifndef SecGame_hh
+#define SecGame_hh
+
+
+#include "Game.hh"
+
+
+/** \file
+ * Contains the SecGame class, which plays a game with every player
+ * in its own process.
+ */
+
+
+/**
+ * Options of a secure game, besides those of Game.
+ */
+struct SecGame_options {
+
+  string exe_dir;   // Directory with the AI<name>.exe files.
+  int memory_mb;    // Address space of each player process in MB, or 0.
+  double timeout;   // Wall seconds to wait for a player in a round, or 0.
+
+  SecGame_options () : exe_dir("."), memory_mb(0), timeout(0) { }
+
+};
+
+
+/**
+ * Plays games where every player runs in its own process, the
+ * executable AI<name>.exe built from its object file and SecMain.
+ * The name is the one the player registers with, not the one of its
+ * source file: AISilverBullet.cc registers Berumotto and runs as
+ * AIBerumotto.exe, which make links to AISilverBullet.exe.
+ *
+ * Each player process shares a memory segment with the game. Every
+ * round the game writes there a binary snapshot of the state, hands the
+ * turn to the player by changing a futex word, and waits for the player
+ * to write its movements and hand the turn back. Nothing is parsed, and
+ * the handshake costs a few microseconds.
+ *
+ * The cpu time of each process is measured with its cpu clock and
+ * enforced as in Game. The whole game budget is also set as the cpu
+ * limit of the process, and the memory limit as its address space
+ * limit. Players that ponder do it in a thread of their process, and
+ * the cpu time of the process between rounds counts as pondering. The
+ * worker threads of a player live in its process too, so their cpu time
+ * is included. A player that dies, goes over its budget or does not answer
+ * in time is disqualified, and its process killed.
+ */
+class SecGame {
+
+  /**
+   * Whose turn it is, stored in the futex word of the shared segment.
+   */
+  enum Turn { MasterTurn, PlayerTurn, InitTurn, QuitTurn };
+
+  /**
+   * Start of the shared segment, followed by the arrays of the snapshot.
+   */
+  struct Header {
+    int turn;           // A Turn, changed with atomic operations.
+    int me;             // Identifier of the player.
+    int seed;           // Random seed of the player.
+    int round;          // Current round.
+    int nb_actions;     // Movements written by the player.
+    int committed;      // Movements committed by the player, or -1.
+    int ponder;         // Whether the player may ponder after this round.
+    int threads;        // Worker threads of the player.
+    int log_level;      // Least important LogLevel logged by the player.
+    double cpu_round;   // Budget of the round, or 0.
+    double cpu_left;    // Budget left for the game, or 0.
+    Settings settings;  // Settings of the game.
+  };
+
+  /**
+   * Offsets (in bytes) of the arrays of the shared segment.
+   */
+  struct Layout {
+    size_t grid, units, cities, scores, status, actions, size;
+  };
+
+  /**
+   * Returns the layout of the shared segment for the given settings.
+   */
+  static Layout layout (const Settings& s);
+
+  /**
+   * A player process seen from the game.
+   */
+  struct Process {
+    int pid;
+    int fd;
+    char* shm;
+    Layout lay;
+    clockid_t clock;
+    double idle;   // Cpu time of the process when it last answered.
+  };
+
+  /**
+   * Waits until the futex word is different from turn, for at most
+   * timeout seconds (or forever, if 0). If pid is positive, also returns
+   * when that process ends. Returns whether the word changed.
+   */
+  static bool wait_turn (int* word, int turn, double timeout, int pid);
+
+  /**
+   * Stores turn in the futex word and wakes up whoever waits for it.
+   */
+  static void give_turn (int* word, int turn);
+
+  /**
+   * Creates the shared segment and the process of player pl.
+   */
+  static Process launch (const Board& b, int pl, const string& name,
+                         const Game_options& opt, const SecGame_options& sec);
+
+  /**
+   * Kills the process of a player and frees its segment.
+   */
+  static void finish (Process& p, bool kill);
+
+  /**
+   * Writes the state of the board in the segment of a process,
+   * with the budgets for the next call.
+   */
+  static void write_snapshot (const Board& b, Process& p,
+                              double cpu_round, double cpu_left);
+
+  /**
+   * Returns the cpu time used so far by a process, in seconds.
+   */
+  static double cpu_time (const Process& p);
+
+  /**
+   * Runs init() in all the players that have one, in parallel.
+   * Players that fail or go over the budget for init() are disqualified.
+   */
+  static void initialize (Board& b, vector<Process>& procs,
+                          const Game_options& opt, const SecGame_options& sec);
+
+  /**
+   * Plays a round of player pl, which has cpu_left seconds left for the
+   * game (or 0). Stores in pondered the cpu time it used since it last
+   * answered, pondering or not. Returns false if the player failed.
+   */
+  static bool play_round (const Board& b, Process& p, Action& act,
+                          double& used, double& pondered, int& committed,
+                          double cpu_left, const Game_options& opt,
+                          const SecGame_options& sec);
+
+public:
+
+  /**
+   * Plays a game, as Game::run does.
+   */
+  static Game_result run (vector<string> names, istream& is, ostream& os,
+                          int seed, const Game_options& opt = Game_options(),
+                          const SecGame_options& sec = SecGame_options());
+
+  /**
+   * Main loop of a player process: plays with the registered player
+   * name every round, using the segment open as file descriptor fd.
+   */
+  static void run_player (const string& name, int fd);
+
+};
+
+
+#endif
@@ -0,0 +1,177 @@
+#include "SecGame.hh"
+
+
+void help (int argc, char** argv) {
+  cout << "Usage: " << argv[0] << " [options] player1 player2 ... [< default.cnf] [> default.res] " << endl;
+  cout << "Available options:" << endl;
+  cout << "--seed=seed     -s seed     set random seed"                   << endl;
+  cout << "--input=file    -i input    set input file  (default: stdin)"  << endl;
+  cout << "--output=file   -o output   set output file (default: stdout)" << endl;
+  cout << "--decided       -d          stop when the winner cannot change" << endl;
+  cout << "--rng=kind      -r kind     random generator: legacy (default) or counter" << endl;
+  cout << "--cpu=seconds   -t seconds  cpu time of each player for the game" << endl;
+  cout << "--cpu-round=s   -T seconds  cpu time of each player for a round" << endl;
+  cout << "--cpu-init=s    -I seconds  cpu time of each player for init()" << endl;
+  cout << "--ponder        -n          let players ponder between their turns" << endl;
+  cout << "--threads=n     -j n        worker threads of each player (default: 0)" << endl;
+  cout << "--headless      -H          no replay" << endl;
+  cout << "--json=file     -J file     append the results to file as a JSON line" << endl;
+  cout << "--csv=file      -C file     append the results to file as CSV" << endl;
+  cout << "--log=level     -V level    log error, warning, info (default) or debug" << endl;
+  cout << "--memory=mb     -m mb       address space of each player, in MB" << endl;
+  cout << "--timeout=s     -w seconds  wall time to wait for a player in a round" << endl;
+  cout << "--dir=dir       -x dir      directory of the AI<name>.exe files" << endl;
+  cout << "--list          -l          list registered players"           << endl;
+  cout << "--version       -v          print version"                     << endl;
+  cout << "--help          -h          print help"                        << endl;
+}
+
+
+int main (int argc, char** argv) {
+  if (argc == 1) {
+    help(argc, argv);
+    return EXIT_SUCCESS;
+  }
+
+  struct option long_options[] = {
+    { "seed",    required_argument, 0, 's' },
+    { "input",   required_argument, 0, 'i' },
+    { "output",  required_argument, 0, 'o' },
+    { "decided", no_argument,       0, 'd' },
+    { "rng",     required_argument, 0, 'r' },
+    { "cpu",     required_argument, 0, 't' },
+    { "cpu-round", required_argument, 0, 'T' },
+    { "cpu-init", required_argument, 0, 'I' },
+    { "ponder",  no_argument,       0, 'n' },
+    { "threads", required_argument, 0, 'j' },
+    { "headless", no_argument,      0, 'H' },
+    { "json",    required_argument, 0, 'J' },
+    { "csv",     required_argument, 0, 'C' },
+    { "log",     required_argument, 0, 'V' },
+    { "memory",  required_argument, 0, 'm' },
+    { "timeout", required_argument, 0, 'w' },
+    { "dir",     required_argument, 0, 'x' },
+    { "player",  required_argument, 0, 'P' },
+    { "fd",      required_argument, 0, 'F' },
+    { "list",    no_argument,       0, 'l' },
+    { "version", no_argument,       0, 'v' },
+    { "help",    no_argument,       0, 'h' },
+    { 0, 0, 0, 0 }
+  };
+
+  char* ifile = 0;
+  char* ofile = 0;
+  int seed = -1;
+  string json, csv;
+  vector<string> names;
+  Game_options opt;
+  SecGame_options sec;
+  string player;
+  int fd = -1;
+
+  while (true) {
+    int index = 0;
+    int c = getopt_long(argc, argv, "s:i:o:dr:t:T:I:nj:HJ:C:V:m:w:x:P:F:lvh", long_options, &index);
+    if (c == -1) break;
+
+    switch (c) {
+      case 's':
+        seed = string_to_int(optarg);
+        break;
+      case 'i':
+        ifile = optarg;
+        break;
+      case 'o':
+        ofile = optarg;
+        break;
+      case 'd':
+        opt.stop_when_decided = true;
+        break;
+      case 'r':
+        if (string(optarg) == "legacy") opt.rng = LegacyRng;
+        else if (string(optarg) == "counter") opt.rng = CounterRng;
+        else _my_assert(false, "Unknown random generator " + string(optarg) + ".");
+        break;
+      case 't':
+        opt.cpu_total = atof(optarg);
+        break;
+      case 'T':
+        opt.cpu_round = atof(optarg);
+        break;
+      case 'I':
+        opt.cpu_init = atof(optarg);
+        break;
+      case 'n':
+        opt.ponder = true;
+        break;
+      case 'j':
+        opt.threads = string_to_int(optarg);
+        _my_assert(opt.threads >= 0, "Wrong number of threads.");
+        break;
+      case 'H':
+        opt.headless = true;
+        break;
+      case 'J':
+        json = optarg;
+        break;
+      case 'C':
+        csv = optarg;
+        break;
+      case 'V':
+        _my_assert(Log::parse(optarg) != LogLevelSize,
+                   "Unknown log level " + string(optarg) + ".");
+        Log::set_level(Log::parse(optarg));
+        break;
+      case 'm':
+        sec.memory_mb = string_to_int(optarg);
+        break;
+      case 'w':
+        sec.timeout = atof(optarg);
+        break;
+      case 'x':
+        sec.exe_dir = optarg;
+        break;
+      case 'P':
+        player = optarg;
+        break;
+      case 'F':
+        fd = string_to_int(optarg);
+        break;
+      case 'l':
+        Registry::print_players(cout);
+        return EXIT_SUCCESS;
+      case 'v':
+        cout << Board::version() << endl;
+        cout << "compiled " << __TIME__ << " " << __DATE__ << endl;
+        return EXIT_SUCCESS;
+      case 'h':
+        help(argc, argv);
+        return EXIT_SUCCESS;
+      default:
+        return EXIT_FAILURE;
+    }
+  }
+
+  // launched by SecGame as a player process
+  if (not player.empty()) {
+    _my_assert(fd >= 0, "Missing shared memory descriptor.");
+    SecGame::run_player(player, fd);
+    return EXIT_SUCCESS;
+  }
+
+  while (optind < argc) {
+    names.push_back(argv[optind++]);
+    _my_assert(names.back().size() <= 12, "Player name too long.");
+  }
+
+  _my_assert(seed >= 0, "Missing seed?");
+
+  istream* is = ifile ? new ifstream(ifile) : &cin;
+  bool replay = ofile and not opt.headless;
+  ostream* os = replay ? new ofstream(ofile) : &cout;
+
+  SecGame::run(names, *is, *os, seed, opt, sec).save(json, csv);
+
+  if (ifile) delete is;
+  if (replay) delete os;
+}
@@ -3,6 +3,7 @@
 
 
 #include "Structs.hh"
+#include "Warning.hh"
 
 
 /*! \file
@@ -20,6 +21,8 @@ class State {
   friend class Game;
   friend class SecGame;
   friend class Player;
+  friend class Query_cache;
+  friend class Plane_encoder;
 
   vector< vector<Cell> > grid_;
   int round_;
@@ -52,7 +55,8 @@ public:
   inline Cell cell (Pos p) const {
     if (p.i < 0 or p.i >= (int)grid_.size()
         or p.j < 0 or p.j >= (int)grid_[p.i].size()) {
-      cerr << "warning: cell requested for position " << p << endl;
+      if (Warnings::note(BadQuery))
+        _warning("cell requested for position " << p);
       return Cell();
     }
     return grid_[p.i][p.j];
@@ -77,7 +81,8 @@ public:
    */
   inline Unit unit (int id) const {
     if (not unit_ok(id)) {
-      cerr << "warning: unit requested for identifier " << id << endl;
+      if (Warnings::note(BadQuery))
+        _warning("unit requested for identifier " << id);
       return Unit();
     }
     return unit_[id];
@@ -88,7 +93,8 @@ public:
    */
   inline int num_cities (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: score requested for player " << pl << endl;
+      if (Warnings::note(BadQuery))
+        _warning("score requested for player " << pl);
       return -1;
     }
     return num_cities_[pl];
@@ -99,7 +105,8 @@ public:
    */
   inline int total_score (int pl) const {
     if (pl < 0 or pl >= (int)total_score_.size()) {
-      cerr << "warning: total score requested for player " << pl << endl;
+      if (Warnings::note(BadQuery))
+        _warning("total score requested for player " << pl);
       return -1;
     }
     return total_score_[pl];
@@ -112,7 +119,8 @@ public:
    */
   inline double status (int pl) const {
     if (pl < 0 or pl >= (int)cpu_status_.size()) {
-      cerr << "warning: status requested for player " << pl << endl;
+      if (Warnings::note(BadQuery))
+        _warning("status requested for player " << pl);
       return -2;
     }
     return cpu_status_[pl];
@@ -123,7 +131,8 @@ public:
    */
   inline vector<int> warriors (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: warriors requested for player " << pl << endl;
+      if (Warnings::note(BadQuery))
+        _warning("warriors requested for player " << pl);
       return vector<int>();
     }
     return warriors_[pl];
@@ -134,12 +143,65 @@ public:
    */
   inline vector<int> cars (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: cars requested for player " << pl << endl;
+      if (Warnings::note(BadQuery))
+        _warning("cars requested for player " << pl);
       return vector<int>();
     }
     return cars_[pl];
   }
 
+  /**
+   * Returns a reference to the cell at p, without copying it.
+   * The position is only checked when compiling for debugging.
+   */
+  inline const Cell& cell_ref (Pos p) const {
+    _debug_assert(p.i >= 0 and p.i < (int)grid_.size()
+                  and p.j >= 0 and p.j < (int)grid_[p.i].size(),
+                  "cell_ref requested for a position outside the board.");
+    return grid_[p.i][p.j];
+  }
+
+  /**
+   * Returns a reference to the cell at (i, j), without copying it.
+   */
+  inline const Cell& cell_ref (int i, int j) const {
+    return cell_ref(Pos(i, j));
+  }
+
+  /**
+   * Returns a reference to the unit with identifier id, without copying it.
+   * The identifier is only checked when compiling for debugging.
+   */
+  inline const Unit& unit_ref (int id) const {
+    _debug_assert(unit_ok(id), "unit_ref requested for a wrong identifier.");
+    return unit_[id];
+  }
+
+  /**
+   * Returns a view of all the units, indexed by their identifiers.
+   */
+  inline View<Unit> units_view () const {
+    return View<Unit>(unit_);
+  }
+
+  /**
+   * Returns a view of the ids of all the warriors of a player,
+   * without copying them, or an empty view if pl is not a player.
+   */
+  inline View<int> warriors_view (int pl) const {
+    if (_unlikely(pl < 0 or pl >= (int)warriors_.size())) return View<int>();
+    return View<int>(warriors_[pl]);
+  }
+
+  /**
+   * Returns a view of the ids of all the cars of a player,
+   * without copying them, or an empty view if pl is not a player.
+   */
+  inline View<int> cars_view (int pl) const {
+    if (_unlikely(pl < 0 or pl >= (int)cars_.size())) return View<int>();
+    return View<int>(cars_[pl]);
+  }
+
   /**
    * Tells if a unit can move at this round.
    */
@@ -18,9 +18,12 @@
 #include <set>
 #include <algorithm>
 #include <cmath>
+#include <ctime>
 
 using namespace std;
 
+#include "Log.hh"
+
 
 /** \file
  * Contains several useful includes, plus defines for errors and other
@@ -29,9 +32,9 @@ using namespace std;
 
 
 /**
- * Assert with message.
+ * Assert with message, logged as an error after everything logged before.
  */
-#define _my_assert(b, s) { if (not (b)) { cerr << "ERROR: " << s << endl; assert(b); } }
+#define _my_assert(b, s) { if (not (b)) { _error(s); assert(b); } }
 
 
 /**
@@ -41,6 +44,85 @@ using namespace std;
 #define _unreachable() { _my_assert(false, "Unreachable code reached."); }
 
 
+/**
+ * Assert with message that is only checked when compiling for debugging.
+ */
+#ifdef DEBUG
+#define _debug_assert(b, s) _my_assert(b, s)
+#else
+#define _debug_assert(b, s) { }
+#endif
+
+
+/**
+ * Tells the compiler that a condition is most probably false.
+ */
+#define _unlikely(b) __builtin_expect(!!(b), 0)
+
+
+/**
+ * Returns the cpu time used so far by the calling thread, in seconds.
+ * Other threads and processes do not count.
+ */
+inline double thread_cpu_time () {
+  timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+
+/**
+ * Returns the time elapsed since some fixed moment, in seconds.
+ */
+inline double wall_time () {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+
+/**
+ * Read-only view of a contiguous sequence of elements, which does not
+ * own them. It stays valid as long as the viewed container is not modified.
+ */
+template <typename T>
+class View {
+
+  const T* begin_;
+  const T* end_;
+
+public:
+
+  inline View () : begin_(0), end_(0) { }
+
+  inline View (const T* b, const T* e) : begin_(b), end_(e) { }
+
+  inline View (const vector<T>& v) : begin_(v.data()), end_(v.data() + v.size()) { }
+
+  inline const T* begin () const {
+    return begin_;
+  }
+
+  inline const T* end () const {
+    return end_;
+  }
+
+  inline int size () const {
+    return end_ - begin_;
+  }
+
+  inline bool empty () const {
+    return begin_ == end_;
+  }
+
+  inline const T& operator[] (int i) const {
+    _debug_assert(i >= 0 and i < size(), "View index out of range.");
+    return begin_[i];
+  }
+
+};
+
+
 /**
  * C++11 to_string gives problems with Cygwin, so this is a replacement.
  */
@@ -0,0 +1,58 @@
+#include "Warning.hh"
+
+
+int Warning_counts::sample_ = 5;
+Warning_counts Warnings::process_;
+thread_local Warnings::Context Warnings::context_ = { 0, -1 };
+
+
+const char* warning_name (WarningType t) {
+  switch (t) {
+    case IdOutOfRange:    return "id out of range";
+    case NotOwnUnit:      return "not own unit";
+    case InvalidDir:      return "direction not valid";
+    case CannotMove:      return "cannot move";
+    case RepeatedCommand: return "repeated command";
+    case BadQuery:        return "query out of range";
+    case BadInput:        return "incomplete command";
+    default:              return "unknown";
+  }
+}
+
+
+Warning_counts& Warning_counts::operator= (const Warning_counts& w) {
+  for (int pl = 0; pl <= MAX_PLAYERS; ++pl)
+    for (int t = 0; t < WarningTypeSize; ++t) count_[pl][t] = w.count_[pl][t].load();
+  return *this;
+}
+
+
+int Warning_counts::count (int pl) const {
+  int n = 0;
+  for (int t = 0; t < WarningTypeSize; ++t) n += count(pl, WarningType(t));
+  return n;
+}
+
+
+void Warning_counts::clear () {
+  for (int pl = 0; pl <= MAX_PLAYERS; ++pl)
+    for (int t = 0; t < WarningTypeSize; ++t) count_[pl][t] = 0;
+}
+
+
+void Warning_counts::print_summary (const vector<string>& names) const {
+  for (int pl = -1; pl < (int)names.size(); ++pl) {
+    int n = count(pl);
+    if (n == 0) continue;
+    ostringstream os;
+    bool first = true;
+    for (int t = 0; t < WarningTypeSize; ++t) {
+      int k = count(pl, WarningType(t));
+      if (k == 0) continue;
+      os << (first ? "" : ", ") << warning_name(WarningType(t)) << ": " << k;
+      first = false;
+    }
+    _info((pl == -1 ? string("nobody") : "player " + names[pl])
+          << " got " << n << " warnings (" << os.str() << ")");
+  }
+}
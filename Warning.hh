@@ -0,0 +1,240 @@
+#ifndef Warning_hh
+#define Warning_hh
+
+
+#include "Utils.hh"
+#include <atomic>
+
+
+/** \file
+ * Contains the WarningType enumeration, and the Warning_counts and
+ * Warnings classes, which count the invalid requests made by each player.
+ */
+
+
+/**
+ * Enum to encode the reasons of warnings.
+ */
+enum WarningType {
+  IdOutOfRange,     // A command for a unit that does not exist.
+  NotOwnUnit,       // A command for a unit of another player.
+  InvalidDir,       // A command with a direction that does not exist.
+  CannotMove,       // A command for a unit that cannot move this round.
+  RepeatedCommand,  // More than one command for the same unit.
+  BadQuery,         // A query about a cell, unit or player out of range.
+  BadInput,         // An incomplete command read from a stream.
+  WarningTypeSize
+};
+
+
+/**
+ * Returns a short description of a warning reason.
+ */
+const char* warning_name (WarningType t);
+
+
+/**
+ * Counters of the warnings of a game, per player and reason.
+ *
+ * Only the first sample() warnings of each player and reason are
+ * meant to be logged; note() counts every warning and tells whether
+ * it must be written.
+ *
+ * Counters are atomic, so players may run in parallel.
+ */
+class Warning_counts {
+
+  static const int MAX_PLAYERS = 8;
+
+  static int sample_;
+
+  atomic<int> count_[MAX_PLAYERS + 1][WarningTypeSize];
+
+  inline atomic<int>& counter (int pl, WarningType t) {
+    return count_[(pl < 0 or pl >= MAX_PLAYERS) ? MAX_PLAYERS : pl][t];
+  }
+
+  inline const atomic<int>& counter (int pl, WarningType t) const {
+    return count_[(pl < 0 or pl >= MAX_PLAYERS) ? MAX_PLAYERS : pl][t];
+  }
+
+public:
+
+  Warning_counts () {
+    clear();
+  }
+
+  Warning_counts (const Warning_counts& w) {
+    *this = w;
+  }
+
+  Warning_counts& operator= (const Warning_counts& w);
+
+  /**
+   * Counts a warning of player pl (or of nobody, if -1)
+   * and returns whether it must be written.
+   */
+  inline bool note (WarningType t, int pl) {
+    return ++counter(pl, t) <= sample_;
+  }
+
+  /**
+   * Returns the number of warnings of player pl for reason t.
+   */
+  inline int count (int pl, WarningType t) const {
+    return counter(pl, t);
+  }
+
+  /**
+   * Returns the number of warnings of player pl.
+   */
+  int count (int pl) const;
+
+  /**
+   * Sets all the counters to zero.
+   */
+  void clear ();
+
+  /**
+   * Logs the counters of the players with warnings,
+   * using the given names for the players.
+   */
+  void print_summary (const vector<string>& names) const;
+
+  /**
+   * Sets how many warnings of each player and reason are written.
+   */
+  inline static void set_sample (int n) {
+    sample_ = n;
+  }
+
+  inline static int sample () {
+    return sample_;
+  }
+
+};
+
+
+/**
+ * The warnings of the calling thread: they go to the counters of the
+ * game that it is playing (or else to counters of the process), and
+ * are attributed to the player given, or else to the player that is
+ * playing in the thread, or else to nobody (player -1).
+ *
+ * Game sets both for the threads that it starts, and Worker_pool
+ * gives every task those of the thread that queued it.
+ */
+class Warnings {
+
+  static Warning_counts process_;
+
+public:
+
+  /**
+   * Where the warnings of a thread go.
+   */
+  struct Context {
+    Warning_counts* counts;  // Of the game, or 0 for those of the process.
+    int player;              // Playing in the thread, or -1.
+  };
+
+private:
+
+  static thread_local Context context_;
+
+public:
+
+  /**
+   * Sets the context of the calling thread while it exists, and
+   * then restores the previous one.
+   */
+  class Scope {
+
+    Context old_;
+
+  public:
+
+    explicit Scope (Context c) : old_(context_) {
+      context_ = c;
+    }
+
+    Scope (Warning_counts& counts, int pl) : Scope(Context{ &counts, pl }) { }
+
+    ~Scope () {
+      context_ = old_;
+    }
+
+  };
+
+  /**
+   * Returns the context of the calling thread.
+   */
+  inline static Context context () {
+    return context_;
+  }
+
+  /**
+   * Returns the counters of the calling thread.
+   */
+  inline static Warning_counts& counts () {
+    return context_.counts ? *context_.counts : process_;
+  }
+
+  /**
+   * Counts a warning of player pl and returns whether it must be written.
+   */
+  inline static bool note (WarningType t, int pl) {
+    return counts().note(t, pl);
+  }
+
+  /**
+   * Counts a warning of the current player and returns
+   * whether it must be written.
+   */
+  inline static bool note (WarningType t) {
+    return note(t, context_.player);
+  }
+
+  /**
+   * Returns the number of warnings of player pl for reason t.
+   */
+  inline static int count (int pl, WarningType t) {
+    return counts().count(pl, t);
+  }
+
+  /**
+   * Returns the number of warnings of player pl.
+   */
+  inline static int count (int pl) {
+    return counts().count(pl);
+  }
+
+  /**
+   * Sets the player playing in the current thread, or -1 for none.
+   */
+  inline static void set_player (int pl) {
+    context_.player = pl;
+  }
+
+  /**
+   * Returns the player playing in the current thread, or -1.
+   */
+  inline static int player () {
+    return context_.player;
+  }
+
+  /**
+   * Sets how many warnings of each player and reason are written.
+   */
+  inline static void set_sample (int n) {
+    Warning_counts::set_sample(n);
+  }
+
+  inline static int sample () {
+    return Warning_counts::sample();
+  }
+
+};
+
+
+#endif
@@ -22,12 +22,13 @@ for (( i = 1; i <= $GAMES; i++ )); do
 
     echo -ne "Game $i/$GAMES\tSEED: $SEED RUNNING ...\r"
 
-    ./Game $PNAME Dummy Dummy Dummy -s $SEED -i default.cnf -o "${OUT_FILE}.res" 2>"${OUT_FILE}"
+    ./Game $PNAME Dummy Dummy Dummy -s $SEED -i default.cnf -o "${OUT_FILE}.res" -C "${OUT_FILE}.csv" 2>"${OUT_FILE}"
 
-    WINNER=$(tail -n 2 "${OUT_FILE}" | head -n 1 | cut -d' ' -f 3)
+    # columns: seed,rounds,seconds,player,name,score,winner,cpu,cities,upper
+    WINNER=$(awk -F, 'NR > 1 && $7 == 1 { print $5; exit }' "${OUT_FILE}.csv")
 
-    POINTS_PNAME=$(tail -n 6 ${OUT_FILE}| grep "${PNAME} got score" | cut -d' ' -f 6 | sort | head -n 1)
-    POINTS_WINNER=$(tail -n 6 ${OUT_FILE}| grep "${WINNER} got score" | cut -d' ' -f 6 | sort | head -n 1)
+    POINTS_PNAME=$(awk -F, -v p="${PNAME}" 'NR > 1 && $5 == p { print $6 }' "${OUT_FILE}.csv" | sort -n | head -n 1)
+    POINTS_WINNER=$(awk -F, -v p="${WINNER}" 'NR > 1 && $5 == p { print $6 }' "${OUT_FILE}.csv" | sort -n | head -n 1)
     POINTS=$((POINTS+POINTS_PNAME))
 
     echo -e "Game $i/$GAMES\tSEED: $SEED WINNER: $WINNER ($POINTS_WINNER)"
@@ -35,10 +36,12 @@ for (( i = 1; i <= $GAMES; i++ )); do
     if [ "$WINNER" = "$PNAME" ]; then
         mv "${OUT_FILE}.res" "${RESULT_FOLDER}/W_$SEED.res"
         mv "${OUT_FILE}" "${RESULT_FOLDER}/W_$SEED.txt"
+        mv "${OUT_FILE}.csv" "${RESULT_FOLDER}/W_$SEED.csv"
         CONT=$((CONT+1))
     else
         mv "${OUT_FILE}.res" "${RESULT_FOLDER}/L_$SEED.res"
         mv "${OUT_FILE}" "${RESULT_FOLDER}/L_$SEED.txt"
+        mv "${OUT_FILE}.csv" "${RESULT_FOLDER}/L_$SEED.csv"
         echo -e "\t\t\t\t\t $PNAME ($POINTS_PNAME)"
     fi
 done
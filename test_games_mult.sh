@@ -11,21 +11,25 @@ PVERSION=$(md5sum AI$PNAME.cc | cut -d' ' -f1)
 
 mkdir -p $RESULT_FOLDER
 mkdir -p $RESULT_FOLDER/bk
-mv $RESULT_FOLDER/*.{txt,res} $RESULT_FOLDER/bk
+mv $RESULT_FOLDER/*.{txt,res,csv} $RESULT_FOLDER/bk
 CONT=0
 
 for (( i = 0; i < $GAMES; i++ )); do
     SEED=$(shuf -i 0-2147483647 -n 1)
     printf -v PSEED "%010d" $SEED
-    RESULT=$(./Game $PNAME $P2 $P3 $P4 -s $SEED -i default.cnf -o ${RESULT_FOLDER}/$PSEED.res 2>&1 >/dev/null | tee ${RESULT_FOLDER}/$PSEED | tail -n 2 | head -n 1 | cut -d' ' -f 3)
+    ./Game $PNAME $P2 $P3 $P4 -s $SEED -i default.cnf -o ${RESULT_FOLDER}/$PSEED.res -C ${RESULT_FOLDER}/$PSEED.csv 2>${RESULT_FOLDER}/$PSEED
+    # columns: seed,rounds,seconds,player,name,score,winner,cpu,cities,upper
+    RESULT=$(awk -F, 'NR > 1 && $7 == 1 { print $5; exit }' ${RESULT_FOLDER}/$PSEED.csv)
     echo "GAME $((i+1)) of $GAMES: SEED: $SEED. WINNER: $RESULT"
     if [ "$RESULT" = "$PNAME" ]; then
         mv "${RESULT_FOLDER}/$PSEED.res" "${RESULT_FOLDER}/W_$PSEED.res"
         mv "${RESULT_FOLDER}/$PSEED" "${RESULT_FOLDER}/W_$PSEED.txt"
+        mv "${RESULT_FOLDER}/$PSEED.csv" "${RESULT_FOLDER}/W_$PSEED.csv"
         CONT=$((CONT+1))
     else
         mv "${RESULT_FOLDER}/$PSEED.res" "${RESULT_FOLDER}/L_$PSEED.res"
         mv "${RESULT_FOLDER}/$PSEED" "${RESULT_FOLDER}/L_$PSEED.txt"
+        mv "${RESULT_FOLDER}/$PSEED.csv" "${RESULT_FOLDER}/L_$PSEED.csv"
     fi
 done
 
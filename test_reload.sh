@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+
+# Checks that players loaded with --load run their own code, even when a
+# player with the same name is linked into Game, and that a library moved
+# over the loaded one is used from the next game on, and that the linked in
+# player is used again once the library is removed.
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+# a copy of Null that logs a mark on its first round
+version () {
+    sed -e "s|#include \"Player.hh\"|#include \"$PWD/Player.hh\"|" \
+        -e "s|virtual void play () {|virtual void play () {\n    if (round() == 0) _info(\"reload mark $1\");|" \
+        AINull.cc > "$DIR/src/AINull.cc"
+    make -s "$DIR/src/AINull.so" || exit 1
+}
+
+mkdir -p "$DIR/src" "$DIR/lib"
+version 1
+mv "$DIR/src/AINull.so" "$DIR/lib/AINull.so"
+version 2
+
+./Game -L "$DIR/lib" Demo Demo Demo Null -s 1 -g 3 -i default.cnf -o "$DIR/out" 2>"$DIR/log" &
+GAME=$!
+
+# the second version replaces the first one while the first game runs
+while ! grep -qs "reload mark 1" "$DIR/log"; do
+    kill -0 $GAME 2>/dev/null || break
+    sleep 0.01
+done
+mv "$DIR/src/AINull.so" "$DIR/lib/AINull.so"
+
+# and is removed while the second game runs
+while ! grep -qs "reload mark 2" "$DIR/log"; do
+    kill -0 $GAME 2>/dev/null || break
+    sleep 0.01
+done
+rm "$DIR/lib/AINull.so"
+wait $GAME
+
+MARKS=$(grep "reload mark" "$DIR/log" | cut -d' ' -f 4 | tr '\n' ' ')
+GAMES=$(grep -c "game played" "$DIR/log")
+if [ "$MARKS" = "1 2 " ] && [ "$GAMES" = 3 ]; then
+    echo "reload OK"
+else
+    echo "reload FAILED: marks '$MARKS', $GAMES games"
+    exit 1
+fi